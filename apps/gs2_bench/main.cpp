@@ -0,0 +1,392 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <getopt.h>
+
+#include "gs2.hpp"
+#include "cpu.hpp"
+#include "memory.hpp"
+#include "bus.hpp"
+#include "debug.hpp"
+#include "platforms.hpp"
+#include "display/display.hpp"
+#include "display/hgr_280x192.hpp"
+#include "display/hgr_560x192.hpp"
+#include "display/video_scanner.hpp"
+#include "devices/speaker/speaker.hpp"
+#include "devices/diskii/diskii_fmt.hpp"
+#include "util/reset.hpp"
+
+/**
+ * gs2_bench
+ *
+ * Fixed-input microbenchmarks for the hot paths that aren't the CPU: display
+ * line rendering, speaker synthesis, the 5.25 nibblizer, the bus ($C800 slot
+ * ROM switching, the floating bus) and RESET. Everything runs
+ * into in-memory buffers - the display state is set up by hand and never gets
+ * a window, texture or audio stream.
+ *
+ * Inputs are synthetic but deterministic (fixed-seed fill), so numbers are
+ * comparable run to run. Results go to stdout as JSON, ns per op.
+ */
+
+uint64_t debug_level = 0;
+gs2_app_t gs2_app_values;
+
+/* Fixed-seed fill, so every run renders the same screens. */
+static uint32_t bench_seed = 0x12345678;
+static uint8_t bench_random() {
+    bench_seed = bench_seed * 1103515245 + 12345;
+    return (bench_seed >> 16) & 0xFF;
+}
+
+struct bench_result {
+    std::string name;
+    uint64_t iterations;
+    double ns_per_op;
+};
+
+static std::vector<bench_result> results;
+static const char *bench_filter = nullptr;
+static double bench_min_ms = 200.0;
+
+/**
+ * Run fn until at least bench_min_ms has gone by, doubling the batch each time
+ * so the clock isn't read per op. One untimed warmup call first.
+ */
+template <typename F> static void bench(const char *name, F fn) {
+    if (bench_filter && strstr(name, bench_filter) == nullptr) return;
+
+    fn();
+
+    uint64_t iterations = 0;
+    uint64_t batch = 1;
+    std::chrono::steady_clock::duration elapsed {};
+    while (std::chrono::duration<double, std::milli>(elapsed).count() < bench_min_ms) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < batch; i++) fn();
+        elapsed += std::chrono::steady_clock::now() - start;
+        iterations += batch;
+        batch *= 2;
+    }
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    results.push_back({ name, iterations, ns });
+    fprintf(stderr, "%-36s %12.1f ns/op  (%llu iterations)\n", name, ns, (unsigned long long)iterations);
+}
+
+/**
+ * Display. 48K of RAM mapped flat, with text page 1 and hires page 1 (main
+ * and aux) full of fixed-seed junk, and a made-up character ROM. The display state is the real
+ * display_state_t, just never attached to SDL.
+ */
+static void setup_display(cpu_state *cpu, rom_data *rd) {
+    cpu->memory = new memory_map();
+    cpu->main_ram_64 = new uint8_t[0xC000];
+    for (int page = 0; page < 0xC0; page++) {
+        memory_map_page_both(cpu, page, cpu->main_ram_64 + page * GS2_PAGE_SIZE, MEM_RAM);
+    }
+    for (int i = 0; i < 0xC000; i++) cpu->main_ram_64[i] = bench_random();
+    cpu->aux_ram_64 = new uint8_t[0xC000];
+    for (int i = 0; i < 0xC000; i++) cpu->aux_ram_64[i] = bench_random();
+
+    rd->char_rom_data = (char_rom_t *)new char_rom_t;
+    for (int i = 0; i < (int)sizeof(char_rom_t); i++) (*rd->char_rom_data)[i] = bench_random() & 0x7F;
+    pre_calculate_font(rd);
+
+    display_state_t *ds = new display_state_t;
+    set_module_state(cpu, MODULE_DISPLAY, ds);
+    update_line_mode(cpu);
+}
+
+static void bench_display(cpu_state *cpu) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+    int y = 0;
+    auto one_line = [&]() {
+        render_line(cpu, y);
+        y = (y + 1) % 24;
+    };
+
+    struct {
+        const char *name;
+        display_mode_t mode;
+        display_graphics_mode_t graphics;
+        display_color_mode_t color;
+        display_col_mode_t cols;
+    } cases[] = {
+        { "render_line/text/color",    TEXT_MODE,     LORES_MODE, DM_COLOR_MODE, COL40_MODE },
+        { "render_line/text/mono",     TEXT_MODE,     LORES_MODE, DM_GREEN_MODE, COL40_MODE },
+        { "render_line/lores/color",   GRAPHICS_MODE, LORES_MODE, DM_COLOR_MODE, COL40_MODE },
+        { "render_line/hires/color",   GRAPHICS_MODE, HIRES_MODE, DM_COLOR_MODE, COL40_MODE },
+        { "render_line/hires/mono",    GRAPHICS_MODE, HIRES_MODE, DM_GREEN_MODE, COL40_MODE },
+        { "render_line/text80/color",  TEXT_MODE,     LORES_MODE, DM_COLOR_MODE, COL80_MODE },
+        { "render_line/dlores/color",  GRAPHICS_MODE, LORES_MODE, DM_COLOR_MODE, COL80_MODE },
+        { "render_line/dhires/color",  GRAPHICS_MODE, HIRES_MODE, DM_COLOR_MODE, COL80_MODE },
+        { "render_line/dhires/mono",   GRAPHICS_MODE, HIRES_MODE, DM_GREEN_MODE, COL80_MODE },
+    };
+    for (auto &c : cases) {
+        set_split_mode(cpu, FULL_SCREEN);
+        set_col_mode(cpu, c.cols);
+        set_dhires(cpu, c.cols == COL80_MODE);
+        set_graphics_mode(cpu, c.graphics);
+        set_display_mode(cpu, c.mode);
+        ds->color_mode = c.color;
+        y = 0;
+        bench(c.name, one_line);
+    }
+
+    /* the hires and double hires scanline renderers on their own, without render_line's dispatch */
+    ds->color_mode = DM_COLOR_MODE;
+    bench("render_hgr_scanline_color", [&]() {
+        render_hgr_scanline_color(cpu, y, ds->framebuffer + y * 8 * BASE_WIDTH, FRAMEBUFFER_PITCH);
+        y = (y + 1) % 24;
+    });
+    ds->color_mode = DM_GREEN_MODE;
+    bench("render_hgr_scanline_mono", [&]() {
+        render_hgr_scanline_mono(cpu, y, ds->framebuffer + y * 8 * BASE_WIDTH, FRAMEBUFFER_PITCH);
+        y = (y + 1) % 24;
+    });
+    ds->color_mode = DM_COLOR_MODE;
+    bench("render_dhgr_scanline_color", [&]() {
+        render_dhgr_scanline_color(cpu, y, ds->framebuffer + y * 8 * BASE_WIDTH, FRAMEBUFFER_PITCH);
+        y = (y + 1) % 24;
+    });
+    ds->color_mode = DM_GREEN_MODE;
+    bench("render_dhgr_scanline_mono", [&]() {
+        render_dhgr_scanline_mono(cpu, y, ds->framebuffer + y * 8 * BASE_WIDTH, FRAMEBUFFER_PITCH);
+        y = (y + 1) % 24;
+    });
+}
+
+/**
+ * $C800-$CFFF slot ROM switching. A card in slot 4 with a 2K expansion ROM,
+ * like the memory expansion card. One op is one bus access.
+ *  CFFF_idle:   $CFFF with no slot selected - what firmware that touches it
+ *               defensively on every call does most of the time.
+ *  select_release: $C400 then $CFFF, so every access switches.
+ *  floating_bus: an unclaimed $C0xx read, answered from the video scanner
+ *               address. Cycles advance between reads, as in a sync loop.
+ */
+static uint8_t bench_c8_rom[0x800];
+
+static void bench_bus(cpu_state *cpu) {
+    cpu->main_io_4 = new uint8_t[0x1000]();
+    for (int page = 0xC0; page < 0xD0; page++) {
+        memory_map_page_both(cpu, page, cpu->main_io_4 + (page - 0xC0) * GS2_PAGE_SIZE, MEM_IO);
+    }
+    for (int page = 0; page < 8; page++) {
+        cpu->C8xx_idle_pages[page] = cpu->main_io_4 + (page + 0x08) * GS2_PAGE_SIZE;
+    }
+    register_C8xx_rom(cpu, 4, bench_c8_rom);
+    cpu->C8xx_slot = 0xFF;
+
+    uint8_t sink = 0;
+    bench("bus/CFFF_idle", [&]() {
+        sink += memory_bus_read(cpu, 0xCFFF);
+    });
+    uint16_t addr = 0xC400;
+    bench("bus/C8xx_select_release", [&]() {
+        sink += memory_bus_read(cpu, addr);
+        addr ^= (0xC400 ^ 0xCFFF);
+    });
+    init_video_scanner();
+    bench("bus/floating_bus", [&]() {
+        sink += memory_bus_read(cpu, 0xC0F0); // nothing registered
+        cpu->cycles += 4;
+    });
+    if (sink == 0x5A) fprintf(stderr, " ");
+}
+
+/**
+ * The video write hook every guest RAM store goes through after the store
+ * itself (memory_bus_write). One op is one store, walking 256 bytes of one page.
+ *  hgr_page_text_mode: $2000-$3FFF while text page 1 is up (HGR clears, loaders).
+ *  text_page_text_mode: $0400-$07FF, shown, so a line gets marked dirty.
+ *  zero_page:          nowhere near video memory.
+ */
+static void bench_ram_writes(cpu_state *cpu) {
+    set_display_page(cpu, DISPLAY_PAGE_1);
+    set_display_mode(cpu, TEXT_MODE);
+    set_split_mode(cpu, FULL_SCREEN);
+    set_col_mode(cpu, COL40_MODE);
+
+    struct {
+        const char *name;
+        uint16_t base;
+    } cases[] = {
+        { "bus_write/hgr_page_text_mode",  0x2000 },
+        { "bus_write/text_page_text_mode", 0x0400 },
+        { "bus_write/zero_page",           0x0000 },
+    };
+    for (auto &c : cases) {
+        uint8_t offset = 0;
+        bench(c.name, [&]() {
+            memory_bus_write(cpu, c.base + offset, offset);
+            offset++;
+        });
+    }
+}
+
+/**
+ * system_reset, as a test harness that resets over and over sees it: the
+ * power-on page table copied back, then the registered handlers (here just
+ * the display's), then the vector fetch. Nothing runs after, so the junk
+ * vector doesn't matter.
+ */
+static void bench_reset(cpu_state *cpu) {
+    cpu->main_rom_D0 = new uint8_t[0x3000]();
+    for (int page = 0xD0; page < 0x100; page++) {
+        memory_map_page_both(cpu, page, cpu->main_rom_D0 + (page - 0xD0) * GS2_PAGE_SIZE, MEM_ROM);
+    }
+    save_reset_memory_map(cpu);
+    register_reset_handler(cpu, display_reset);
+
+    bench("reset/system_reset", [&]() {
+        system_reset(cpu, false);
+    });
+}
+
+/**
+ * Speaker. One op is one audio frame (735 samples over 17008 cycles) from a
+ * canned toggle buffer: a square wave with some jitter, about what a game
+ * beeping away puts in the queue.
+ */
+static void bench_speaker() {
+    const uint64_t frame_cycles = 17008;
+    const int samples = 735;
+
+    speaker_state_t *speaker_state = new speaker_state_t;
+    EventBuffer *eb = &speaker_state->event_buffer;
+    int n = 0;
+    for (uint64_t cyc = 0; cyc < frame_cycles && n < EVENT_BUFFER_SIZE; n++) {
+        eb->events[n] = cyc;
+        cyc += 40 + (bench_random() & 0x3F);
+    }
+    int16_t *out = new int16_t[SAMPLE_BUFFER_SIZE];
+
+    bench("speaker_synthesize/frame", [&]() {
+        /* re-arm the canned events; pop doesn't overwrite them */
+        eb->read_pos = 0;
+        eb->write_pos = n;
+        eb->count = n;
+        speaker_synthesize(speaker_state, out, samples, 0, frame_cycles);
+    });
+    bench("speaker_synthesize/silent_frame", [&]() {
+        eb->read_pos = eb->write_pos = eb->count = 0;
+        speaker_synthesize(speaker_state, out, samples, 0, frame_cycles);
+    });
+
+    delete[] out;
+    delete speaker_state;
+}
+
+/**
+ * 5.25 nibblizer: one 256-byte sector through prenibble, and one whole
+ * 16-sector track through emit_track. Then the way back: a track through
+ * denibblize_track, and the whole disk through denibblize_disk.
+ */
+static void bench_diskii_fmt() {
+    disk_image_t *image = new disk_image_t;
+    nibblized_disk_t *disk = new nibblized_disk_t();
+    uint8_t *raw = (uint8_t *)image->sectors;
+    for (size_t i = 0; i < sizeof(image->sectors); i++) raw[i] = bench_random();
+    memcpy(disk->interleave_phys_to_logical, do_phys_to_logical, sizeof(interleave_t));
+    memcpy(disk->interleave_logical_to_phys, do_logical_to_phys, sizeof(interleave_t));
+
+    sector_62_t nbuf;
+    int s = 0;
+    bench("diskii_fmt/prenibble", [&]() {
+        prenibble(image->sectors[s / 16][s % 16], nbuf);
+        s = (s + 1) % (TRACKS_PER_DISK * SECTORS_PER_TRACK);
+    });
+
+    int t = 0;
+    bench("diskii_fmt/emit_track", [&]() {
+        disk->tracks[t].position = 0;
+        disk->tracks[t].size = 0;
+        emit_track(*disk, *image, DEFAULT_VOLUME, t);
+        t = (t + 1) % TRACKS_PER_DISK;
+    });
+
+    // emit_track above left every track freshly nibblized.
+    sector_t phys[SECTORS_PER_TRACK];
+    bench("diskii_fmt/denibblize_track", [&]() {
+        denibblize_track(disk->tracks[t].data, disk->tracks[t].size, phys);
+        t = (t + 1) % TRACKS_PER_DISK;
+    });
+
+    disk_image_t *back = new disk_image_t;
+    bench("diskii_fmt/denibblize_disk", [&]() {
+        denibblize_disk(*disk, *back);
+    });
+    delete back;
+
+    delete disk;
+    delete image;
+}
+
+static void print_json() {
+    printf("{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        printf("    { \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f }%s\n",
+            results[i].name.c_str(), (unsigned long long)results[i].iterations, results[i].ns_per_op,
+            (i + 1 < results.size()) ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-f filter] [-t min_ms]\n", prog);
+    fprintf(stderr, "  -f  only run benchmarks whose name contains filter\n");
+    fprintf(stderr, "  -t  minimum time per benchmark, in ms (default 200)\n");
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "f:t:")) != -1) {
+        switch (opt) {
+            case 'f':
+                bench_filter = optarg;
+                break;
+            case 't':
+                bench_min_ms = atof(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+
+    cpu_state *cpu = new cpu_state();
+    rom_data *rd = new rom_data();
+    setup_display(cpu, rd);
+
+    bench_display(cpu);
+    bench_bus(cpu);
+    bench_ram_writes(cpu);
+    bench_reset(cpu);
+    bench_speaker();
+    bench_diskii_fmt();
+
+    print_json();
+    return 0;
+}
@@ -30,28 +30,94 @@ uint64_t debug_level = 0 /* DEBUG_DISKII_FORMAT */;
  * for now, read only!
  */
 
+/**
+ * -t: round-trip self test, run by ctest. Nibblize a fixed-seed image and
+ * decode it back, then decode the outermost and innermost tracks starting
+ * at every possible rotation - a .nib capture can start anywhere on the
+ * track, so fields that wrap past the end have to be found too.
+ */
+static int self_test() {
+    static disk_image_t disk_image;
+    static disk_image_t decoded;
+    static nibblized_disk_t disk;
+    memcpy(disk.interleave_phys_to_logical, do_phys_to_logical, sizeof(interleave_t));
+    memcpy(disk.interleave_logical_to_phys, do_logical_to_phys, sizeof(interleave_t));
+
+    uint32_t seed = 0x12345678;
+    for (int t = 0; t < TRACKS_PER_DISK; t++) {
+        for (int s = 0; s < SECTORS_PER_TRACK; s++) {
+            for (int i = 0; i < SECTOR_SIZE; i++) {
+                seed = seed * 1103515245 + 12345;
+                disk_image.sectors[t][s][i] = seed >> 16;
+            }
+        }
+    }
+    emit_disk(disk, disk_image, DEFAULT_VOLUME);
+
+    int failures = 0;
+    int missing = denibblize_disk(disk, decoded);
+    if (missing || memcmp(&disk_image, &decoded, sizeof(disk_image)) != 0) {
+        fprintf(stderr, "round trip: %d sectors missing or different\n", missing);
+        failures++;
+    }
+
+    static uint8_t rotated[TRACK_MAX_SIZE];
+    int tracks[] = { 0, TRACKS_PER_DISK - 1 };
+    for (int t : tracks) {
+        track_t &track = disk.tracks[t];
+        sector_t expect[SECTORS_PER_TRACK];
+        sector_t got[SECTORS_PER_TRACK];
+        denibblize_track(track.data, track.size, expect);
+        for (int start = 0; start < track.size; start++) {
+            memcpy(rotated, track.data + start, track.size - start);
+            memcpy(rotated + track.size - start, track.data, start);
+            uint16_t found = denibblize_track(rotated, track.size, got);
+            if (found != 0xFFFF || memcmp(expect, got, sizeof(expect)) != 0) {
+                fprintf(stderr, "track %d rotated by %d: sectors found %04X\n", t, start, found);
+                failures++;
+            }
+        }
+    }
+    printf("%s\n", failures ? "nibblizer self test: FAIL" : "nibblizer self test: ok");
+    return failures ? 1 : 0;
+}
+
 void print_usage(const char* program_name) {
-    fprintf(stderr, "Usage: %s [-v] [-o output.nib] input_file\n", program_name);
-    fprintf(stderr, "  -o filename    Write output to filename (default: output.nib)\n");
+    fprintf(stderr, "Usage: %s [-v] [-d] [-p] [-o output] input_file\n", program_name);
+    fprintf(stderr, "       %s -t\n", program_name);
+    fprintf(stderr, "  -o filename    Write output to filename (default: output.nib, or output.dsk with -d)\n");
+    fprintf(stderr, "  -d            Denibblize: read a .nib and write a raw sector image\n");
+    fprintf(stderr, "  -p            ProDOS sector order (.po) instead of DOS 3.3 (.do/.dsk)\n");
     fprintf(stderr, "  -v            Verbose mode - dump disk information\n");
+    fprintf(stderr, "  -t            Run the nibblize / denibblize self test\n");
     exit(1);
 }
 
 int main(int argc, char *argv[]) {
-    const char* output_filename = "output.nib";
+    const char* output_filename = nullptr;
     const char* input_filename = nullptr;
     bool verbose = false;
+    bool denibblize = false;
+    bool prodos_order = false;
     int opt;
 
     // Process command line options
-    while ((opt = getopt(argc, argv, "o:v")) != -1) {
+    while ((opt = getopt(argc, argv, "o:vdpt")) != -1) {
         switch (opt) {
             case 'o':
                 output_filename = optarg;
                 break;
+            case 'd':
+                denibblize = true;
+                break;
+            case 'p':
+                prodos_order = true;
+                break;
             case 'v':
                 verbose = true;
                 break;
+            case 't':
+                return self_test();
             default:
                 print_usage(argv[0]);
         }
@@ -63,12 +129,31 @@ int main(int argc, char *argv[]) {
     }
     input_filename = argv[optind];
 
+    if (output_filename == nullptr) {
+        output_filename = denibblize ? "output.dsk" : "output.nib";
+    }
+
     nibblized_disk_t disk = { };       // start with zeroed disk.
-    memcpy(disk.interleave_phys_to_logical, do_phys_to_logical, sizeof(interleave_t));
-    memcpy(disk.interleave_logical_to_phys, do_logical_to_phys, sizeof(interleave_t));
+    memcpy(disk.interleave_phys_to_logical, prodos_order ? po_phys_to_logical : do_phys_to_logical, sizeof(interleave_t));
+    memcpy(disk.interleave_logical_to_phys, prodos_order ? po_logical_to_phys : do_logical_to_phys, sizeof(interleave_t));
     
     sector_t sectors[16];
-    disk_image_t disk_image;
+    disk_image_t disk_image = { };
+
+    if (denibblize) {
+        if (load_nib_image(disk, input_filename) < 0) {
+            fprintf(stderr, "Failed to load nib image: %s\n", input_filename);
+            exit(1);
+        }
+        int missing = denibblize_disk(disk, disk_image);
+        if (missing) {
+            fprintf(stderr, "%d sectors missing or bad, left zeroed\n", missing);
+        }
+        if (verbose) {
+            dump_disk_image(disk_image);
+        }
+        return write_disk_image(disk_image, output_filename) < 0 || missing ? 1 : 0;
+    }
 
     int ret = load_disk_image(disk_image, input_filename);
     if (ret < 0) {
@@ -15,267 +15,187 @@
  *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include <iostream>
 #include <cstdio>
-#include <unistd.h>
-#include <sstream>
-#include <iomanip>
-#include <time.h>
-#include <mach/mach_time.h>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <chrono>
 #include <getopt.h>
 
-#include "gs2.hpp"
 #include "cpu.hpp"
 #include "clock.hpp"
 #include "memory.hpp"
-#include "display/display.hpp"
-#include "opcodes.hpp"
 #include "debug.hpp"
-#include "test.hpp"
-#include "display/text_40x24.hpp"
-#include "event_poll.hpp"
-#include "devices/keyboard/keyboard.hpp"
-#include "devices/speaker/speaker.hpp"
-#include "devices/loader.hpp"
-#include "platforms.hpp"
 
 /**
- * References: 
- * Apple Machine Language: Don Inman, Kurt Inman
- * https://www.righto.com/2012/12/the-6502-overflow-flag-explained.html?m=1
- * https://www.masswerk.at/6502/6502_instruction_set.html#USBC
- * 
+ * test_6502
+ *
+ * Runs a 6502 / 65C02 functional test image (e.g. Klaus Dormann's
+ * 6502_functional_test.bin or 65C02_extended_opcodes_test.bin) against our
+ * CPU cores, in a flat 64K of RAM. No SDL, no display, no bus devices - just
+ * the core, so it builds and runs anywhere.
+ *
+ * The test images end by trapping: a branch or jump to itself. We run until
+ * the PC stops moving, then compare the trap address with the image's
+ * "success" address. Along the way we time the run with steady_clock and
+ * report emulated MHz and ns per instruction, so a core change gets checked
+ * for speed as well as correctness.
+ *
+ * Exit status is 0 on pass, 1 on a failure trap / runaway / too slow, 2 on usage errors.
  */
 
 /**
- * gssquared
- * 
- * Apple II/+/e/c/GS Emulator Extraordinaire
- * 
- * Main component Goals:
- *  - 6502 CPU (nmos) emulation
- *  - 65c02 CPU (cmos) emulation
- *  - 65sc816 CPU (8 and 16-bit) emulation
- *  - Display Emulation
- *     - Text - 40 / 80 col
- *     - Lores - 40 x 40, 40 x 48, 80 x 40, 80 x 48
- *     - Hires - 280x192 etc.
- *  - Disk I/O
- *   - 5.25 Emulation
- *   - 3.5 Emulation (SmartPort)
- *   - SCSI Card Emulation
- *  - Memory management emulate - a proposed MMU to allow multiple virtual CPUs to each have their own 16M address space
- * User should be able to select the Apple variant: 
- *  - Apple II
- *  - Apple II+
- *  - Apple IIe
- *  - Apple IIe Enhanced
- *  - Apple IIc
- *  - Apple IIc+
- *  - Apple IIGS
- * and edition of ROM.
+ * The cores link against these from memory.cpp / clock.cpp / debug.cpp in the
+ * emulator proper. Here they're flat RAM with no I/O page and no bus hooks.
+ * Like read_memory / write_memory, every bus access costs a cycle.
  */
+static uint8_t flat_ram[0x10000];
 
-/**
- * TODO: Decide whether to implement the 'illegal' instructions. Maybe have that as a processor variant? the '816 does not implement them.
- * 
- */
-
-
-/**
- * initialize memory
- */
-void init_default_memory_map(cpu_state *cpu) {
+uint64_t debug_level = 0;
 
-    for (int i = 0; i < (RAM_KB / GS2_PAGE_SIZE); i++) {
-        cpu->memory->page_info[i + 0x00].type = MEM_RAM;
-        cpu->memory->page_info[i + 0x00].can_read = 1;
-        cpu->memory->page_info[i + 0x00].can_write = 1;
-        cpu->memory->pages_read[i + 0x00] = cpu->main_ram_64 + i * GS2_PAGE_SIZE;
-        cpu->memory->pages_write[i + 0x00] = cpu->main_ram_64 + i * GS2_PAGE_SIZE;
-    }
-    for (int i = 0; i < (IO_KB / GS2_PAGE_SIZE); i++) {
-        cpu->memory->page_info[i + 0xC0].type = MEM_IO;
-        cpu->memory->page_info[i + 0xC0].can_read = 1;
-        cpu->memory->page_info[i + 0xC0].can_write = 1;
-        cpu->memory->pages_read[i + 0xC0] = cpu->main_io_4 + i * GS2_PAGE_SIZE;
-        cpu->memory->pages_write[i + 0xC0] = cpu->main_io_4 + i * GS2_PAGE_SIZE;
-    }
-    for (int i = 0; i < (ROM_KB / GS2_PAGE_SIZE); i++) {
-        cpu->memory->page_info[i + 0xD0].type = MEM_ROM;
-        cpu->memory->page_info[i + 0xD0].can_read = 1;
-        cpu->memory->page_info[i + 0xD0].can_write = 0;
-        cpu->memory->pages_read[i + 0xD0] = cpu->main_rom_D0 + i * GS2_PAGE_SIZE;
-        cpu->memory->pages_write[i + 0xD0] = cpu->main_rom_D0 + i * GS2_PAGE_SIZE;
-    }
+uint8_t read_byte(cpu_state *cpu, uint16_t address) {
+    incr_cycles(cpu);
+    return flat_ram[address];
 }
-void init_memory(cpu_state *cpu) {
-    cpu->memory = new memory_map();
-    
-    cpu->main_ram_64 = new uint8_t[RAM_KB];
-    cpu->main_io_4 = new uint8_t[IO_KB];
-    cpu->main_rom_D0 = new uint8_t[ROM_KB];
 
-    #ifdef APPLEIIGS
-    for (int i = 0; i < RAM_SIZE / GS2_PAGE_SIZE; i++) {
-        cpu->memory->page_info[i].type = MEM_RAM;
-        cpu->memory->pages[i] = new memory_page(); /* do we care if this is aligned */
-        if (!cpu->memory->pages[i]) {
-            std::cerr << "Failed to allocate memory page " << i << std::endl;
-            exit(1);
-        }
-    }
-    #else
-    init_default_memory_map(cpu);
-    #endif
-/*     for (int i = 0; i < 256; i++) {
-        printf("page %02X: %p\n", i, cpu->memory->pages[i]);
-    } */
+uint16_t read_word(cpu_state *cpu, uint16_t address) {
+    return read_byte(cpu, address) | (read_byte(cpu, address + 1) << 8);
 }
 
-uint64_t get_current_time_in_microseconds() {
-    return std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+uint16_t read_word_from_pc(cpu_state *cpu) {
+    uint16_t value = read_word(cpu, cpu->pc);
+    cpu->pc += 2;
+    return value;
 }
 
-void init_cpus() { // this is the same as a power-on event.
-    for (int i = 0; i < MAX_CPUS; i++) {
-        init_memory(&CPUs[i]);
-
-        CPUs[i].boot_time = get_current_time_in_microseconds();
-        CPUs[i].pc = 0x0400;
-        CPUs[i].sp = rand() & 0xFF; // simulate a random stack pointer
-        CPUs[i].a = 0;
-        CPUs[i].x = 0;
-        CPUs[i].y = 0;
-        CPUs[i].p = 0;
-        CPUs[i].cycles = 0;
-        CPUs[i].last_tick = 0;
-
-        //CPUs[i].execute_next = &execute_next_6502;
-
-        set_clock_mode(&CPUs[i], CLOCK_1_024MHZ);
+uint8_t read_byte_from_pc(cpu_state *cpu) {
+    return read_byte(cpu, cpu->pc++);
+}
 
-        CPUs[i].next_tick = mach_absolute_time() + CPUs[i].cycle_duration_ticks; 
-    }
+void write_byte(cpu_state *cpu, uint16_t address, uint8_t value) {
+    incr_cycles(cpu);
+    flat_ram[address] = value;
 }
 
-void set_cpu_processor(cpu_state *cpu, int processor_type) {
-    cpu->execute_next = processor_models[processor_type].execute_next;
+void incr_cycles(cpu_state *cpu) {
+    cpu->cycles++;
 }
 
-void run_cpus(void) {
-    cpu_state *cpu = &CPUs[0];
+struct test_cpu_type {
+    const char *name;
+    execute_next_fn execute_next;
+    uint16_t default_success;  /* where the stock build of the matching test image traps on success */
+};
 
-    uint64_t last_display_update = 0;
-    uint64_t last_5sec_update = 0;
-    uint64_t last_5sec_cycles;
+static const test_cpu_type test_cpu_types[] = {
+    { "6502",  cpu_6502::execute_next,  0x3469 },
+    { "65c02", cpu_65c02::execute_next, 0x24F1 },
+};
 
-    while (1) {
-        if ((cpu->execute_next)(cpu) > 0) {
-            break;
-        }
-        
-        uint64_t current_time = get_current_time_in_microseconds();
-#if 0
-        if (current_time - last_display_update > 16667) {
-            event_poll(cpu); // they say call "once per frame"
-            update_flash_state(cpu);
-            update_display(cpu); // check for events 60 times per second.
-            last_display_update = current_time;
-        }
-#endif
-        if (current_time - last_5sec_update > 5000000) {
-            uint64_t delta = cpu->cycles - last_5sec_cycles;
-            fprintf(stdout, "%llu delta %llu cycles clock-mode: %d CPS: %f MHz [ slips: %llu, busy: %llu, sleep: %llu]\n", delta, cpu->cycles, cpu->clock_mode, (float)delta / float(5000000) , cpu->clock_slip, cpu->clock_busy, cpu->clock_sleep);
-            last_5sec_cycles = cpu->cycles;
-            last_5sec_update = current_time;
-        }
-
-        if (cpu->halt) {
-            update_display(cpu); // update one last time to show the last state.
-            break;
-        }
-    }
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-c 6502|65c02] [-e entry] [-s success] [-n max_instructions] [-m min_mhz] image.bin\n", prog);
+    fprintf(stderr, "  addresses are hex. image is loaded at $0000.\n");
 }
 
-
 int main(int argc, char *argv[]) {
-    std::cout << "Booting GSSquared!" << std::endl;
-
-    int platform_id = 1;  // default to Apple II Plus
+    const test_cpu_type *type = &test_cpu_types[0];
+    uint16_t entry = 0x0400;
+    int success = -1;
+    uint64_t max_instructions = 200000000;
+    double min_mhz = 0.0;
     int opt;
-    
-#if 0
-    while ((opt = getopt(argc, argv, "p:a:b:")) != -1) {
+
+    while ((opt = getopt(argc, argv, "c:e:s:n:m:")) != -1) {
         switch (opt) {
-            case 'p':
-                platform_id = atoi(optarg);
+            case 'c':
+                type = nullptr;
+                for (const test_cpu_type &t : test_cpu_types) {
+                    if (strcasecmp(optarg, t.name) == 0) type = &t;
+                }
+                if (type == nullptr) {
+                    fprintf(stderr, "Unknown cpu type: %s\n", optarg);
+                    usage(argv[0]);
+                    return 2;
+                }
                 break;
-            case 'a':
-                loader_set_file_info(optarg, 0x0801);
+            case 'e':
+                entry = strtoul(optarg, nullptr, 16);
                 break;
-            case 'b':
-                loader_set_file_info(optarg, 0x7000);
+            case 's':
+                success = strtoul(optarg, nullptr, 16);
+                break;
+            case 'n':
+                max_instructions = strtoull(optarg, nullptr, 10);
+                break;
+            case 'm':
+                min_mhz = atof(optarg);
                 break;
             default:
-                fprintf(stderr, "Usage: %s [-p platform] [-a program.bin] [-b loader.bin]\n", argv[0]);
-                exit(1);
+                usage(argv[0]);
+                return 2;
         }
     }
-#endif
-
-    init_cpus();
-
-        // read file 6502_65C02_functional_tests/bin_files/6502_functional_test.bin into a 64k byte array
-
-        uint8_t *memory_chunk = (uint8_t *)malloc(65536); // Allocate 64KB memory chunk
-        if (memory_chunk == NULL) {
-            fprintf(stderr, "Failed to allocate memory\n");
-            exit(1);
-        }
-
-        FILE* file = fopen("6502_65C02_functional_tests/bin_files/6502_functional_test.bin", "rb");
-        if (file == NULL) {
-            fprintf(stderr, "Failed to open file\n");
-            exit(1);
-        }
-        fread(memory_chunk, 1, 65536, file);
-        fclose(file);
-        for (uint64_t i = 0; i < 65536; i++) {
-            raw_memory_write(&CPUs[0], i, memory_chunk[i]);
-        }
-
-
-    set_cpu_processor(&CPUs[0], PROCESSOR_6502);
-
-#if 0
-    if (init_display_sdl(rd)) {
-        fprintf(stderr, "Error initializing display\n");
-        exit(1);
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
     }
+    if (success < 0) success = type->default_success;
 
-    init_keyboard();
-    init_device_display();
-    init_speaker(&CPUs[0]);
-    init_thunderclock(1);
-    diskII_register_slot(&CPUs[0], 6); // put a disk II in slot 6
-#endif
-
-    cpu_reset(&CPUs[0]);
-
-    run_cpus();
-
-    printf("CPU halted: %d\n", CPUs[0].halt);
-    if (CPUs[0].halt == HLT_INSTRUCTION) { // keep screen up and give user a chance to see the last state.
-        printf("Press Enter to continue...");
-        getchar();
+    const char *filename = argv[optind];
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open %s\n", filename);
+        return 2;
+    }
+    size_t loaded = fread(flat_ram, 1, sizeof(flat_ram), file);
+    fclose(file);
+
+    cpu_state *cpu = new cpu_state();
+    cpu->pc = entry;
+    cpu->sp = 0xFF;
+    cpu->p = FLAG_UNUSED | FLAG_I;
+    cpu->cycles = 0;
+    cpu->execute_next = type->execute_next;
+
+    printf("test_6502: %s core, %s (%zu bytes), entry $%04X, success $%04X\n",
+        type->name, filename, loaded, entry, success);
+
+    uint64_t instructions = 0;
+    uint16_t last_pc;
+
+    auto start = std::chrono::steady_clock::now();
+    do {
+        last_pc = cpu->pc;
+        (cpu->execute_next)(cpu);
+        instructions++;
+    } while (cpu->pc != last_pc && instructions < max_instructions);
+    auto end = std::chrono::steady_clock::now();
+
+    uint64_t elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    if (elapsed_ns == 0) elapsed_ns = 1;
+    double mhz = (double)cpu->cycles * 1000.0 / (double)elapsed_ns;
+    double ns_per_instr = (double)elapsed_ns / (double)instructions;
+
+    printf("instructions: %llu  cycles: %llu  elapsed: %.3f ms\n",
+        (unsigned long long)instructions, (unsigned long long)cpu->cycles, elapsed_ns / 1000000.0);
+    printf("speed: %.2f MHz emulated, %.2f ns/instruction\n", mhz, ns_per_instr);
+
+    int status = 0;
+    if (cpu->pc != last_pc) {
+        printf("FAIL: no trap after %llu instructions, PC at $%04X\n", (unsigned long long)instructions, cpu->pc);
+        status = 1;
+    } else if (cpu->pc != success) {
+        printf("FAIL: trapped at $%04X  A:%02X X:%02X Y:%02X P:%02X S:%02X  test case $%02X\n",
+            cpu->pc, cpu->a_lo, cpu->x_lo, cpu->y_lo, cpu->p, (uint8_t)cpu->sp, flat_ram[0x0200]);
+        status = 1;
+    } else {
+        printf("PASS: trapped at success address $%04X\n", cpu->pc);
+    }
+    if (status == 0 && min_mhz > 0.0 && mhz < min_mhz) {
+        printf("FAIL: %.2f MHz is below the %.2f MHz floor\n", mhz, min_mhz);
+        status = 1;
     }
 
-    //dump_full_speaker_event_log();
-
-    free_display();
-
-    debug_dump_memory(&CPUs[0], 0x1230, 0x123F);
-    return 0;
+    delete cpu;
+    return status;
 }
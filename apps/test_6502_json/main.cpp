@@ -0,0 +1,509 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <getopt.h>
+
+#include "cpu.hpp"
+#include "clock.hpp"
+#include "memory.hpp"
+#include "debug.hpp"
+
+/**
+ * test_6502_json
+ *
+ * Single-step opcode tests. Each vector file (00.json .. ff.json, in the
+ * SingleStepTests / ProcessorTests layout) is an array of tests like:
+ *
+ *   { "name": "a9 2c 61",
+ *     "initial": { "pc": 1234, "s": 253, "a": 0, "x": 0, "y": 0, "p": 36, "ram": [ [1234, 169], ... ] },
+ *     "final":   { ... same ... },
+ *     "cycles":  [ [1234, 169, "read"], ... ] }
+ *
+ * We load "initial" into a cpu_state and a flat 64K of RAM, run one instruction,
+ * and compare registers and RAM against "final". The bus cycle list is compared
+ * by count against the cycles the core charged; our cores don't model the dummy
+ * reads, so the access-by-access list is only shown in the mismatch diff, and
+ * cycle count mismatches only fail a test with -x.
+ *
+ * Files are handed out to a pool of worker threads. Each worker has its own RAM
+ * (the memory hooks below are thread_local) and parses its own files, since
+ * parsing is most of the work.
+ */
+
+/**
+ * The memory hooks the cores link against. One flat RAM per thread, and a log
+ * of every access so we can diff it against the expected bus cycles.
+ * Like read_memory / write_memory, every access costs a cycle.
+ */
+struct bus_access {
+    uint16_t address;
+    uint8_t value;
+    bool write;
+};
+
+static thread_local uint8_t *flat_ram = nullptr;
+static thread_local std::vector<bus_access> *bus_log = nullptr;
+
+uint64_t debug_level = 0;
+
+uint8_t read_byte(cpu_state *cpu, uint16_t address) {
+    incr_cycles(cpu);
+    uint8_t value = flat_ram[address];
+    bus_log->push_back({address, value, false});
+    return value;
+}
+
+uint16_t read_word(cpu_state *cpu, uint16_t address) {
+    return read_byte(cpu, address) | (read_byte(cpu, address + 1) << 8);
+}
+
+uint16_t read_word_from_pc(cpu_state *cpu) {
+    uint16_t value = read_word(cpu, cpu->pc);
+    cpu->pc += 2;
+    return value;
+}
+
+uint8_t read_byte_from_pc(cpu_state *cpu) {
+    return read_byte(cpu, cpu->pc++);
+}
+
+void write_byte(cpu_state *cpu, uint16_t address, uint8_t value) {
+    incr_cycles(cpu);
+    flat_ram[address] = value;
+    bus_log->push_back({address, value, true});
+}
+
+void incr_cycles(cpu_state *cpu) {
+    cpu->cycles++;
+}
+
+/**
+ * Test vectors.
+ */
+struct vector_state {
+    uint16_t pc = 0;
+    uint8_t s = 0, a = 0, x = 0, y = 0, p = 0;
+    std::vector<std::pair<uint16_t, uint8_t>> ram;
+};
+
+struct test_vector {
+    std::string name;
+    vector_state initial;
+    vector_state final;
+    std::vector<bus_access> cycles;
+};
+
+/**
+ * Just enough JSON to read the vector files, straight into test_vector.
+ * Keys we don't know are skipped. Returns false on malformed input.
+ */
+struct json_reader {
+    const char *p;
+    const char *end;
+
+    void ws() {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+    }
+    bool expect(char c) {
+        ws();
+        if (p < end && *p == c) { p++; return true; }
+        return false;
+    }
+    bool peek(char c) {
+        ws();
+        return p < end && *p == c;
+    }
+    bool string(std::string &out) {
+        if (!expect('"')) return false;
+        const char *start = p;
+        while (p < end && *p != '"') {
+            if (*p == '\\') p++;
+            p++;
+        }
+        if (p >= end) return false;
+        out.assign(start, p - start);
+        p++;
+        return true;
+    }
+    bool number(long &out) {
+        ws();
+        char *after;
+        out = strtol(p, &after, 10);
+        if (after == p) return false;
+        p = after;
+        return true;
+    }
+    bool skip_value() {
+        ws();
+        if (p >= end) return false;
+        if (*p == '"') { std::string s; return string(s); }
+        if (*p == '{' || *p == '[') {
+            char close = (*p == '{') ? '}' : ']';
+            bool is_object = (*p == '{');
+            p++;
+            if (expect(close)) return true;
+            do {
+                if (is_object) {
+                    std::string key;
+                    if (!string(key) || !expect(':')) return false;
+                }
+                if (!skip_value()) return false;
+            } while (expect(','));
+            return expect(close);
+        }
+        while (p < end && *p != ',' && *p != '}' && *p != ']') p++; /* number, true, false, null */
+        return true;
+    }
+
+    /* [ [addr, value], ... ] or [ [addr, value, "read"], ... ] */
+    template <typename F> bool tuples(F each) {
+        if (!expect('[')) return false;
+        if (expect(']')) return true;
+        do {
+            long addr, value;
+            std::string kind;
+            if (!expect('[') || !number(addr) || !expect(',') || !number(value)) return false;
+            if (expect(',') && !string(kind)) return false;
+            if (!expect(']')) return false;
+            each((uint16_t)addr, (uint8_t)value, kind);
+        } while (expect(','));
+        return expect(']');
+    }
+
+    bool state(vector_state &st) {
+        if (!expect('{')) return false;
+        if (expect('}')) return true;
+        do {
+            std::string key;
+            if (!string(key) || !expect(':')) return false;
+            long v;
+            if (key == "ram") {
+                if (!tuples([&](uint16_t a, uint8_t d, const std::string &) { st.ram.push_back({a, d}); })) return false;
+                continue;
+            }
+            if (key != "pc" && key != "s" && key != "a" && key != "x" && key != "y" && key != "p") {
+                if (!skip_value()) return false;
+                continue;
+            }
+            if (!number(v)) return false;
+            if (key == "pc") st.pc = v;
+            else if (key == "s") st.s = v;
+            else if (key == "a") st.a = v;
+            else if (key == "x") st.x = v;
+            else if (key == "y") st.y = v;
+            else st.p = v;
+        } while (expect(','));
+        return expect('}');
+    }
+
+    bool test(test_vector &t) {
+        if (!expect('{')) return false;
+        if (expect('}')) return true;
+        do {
+            std::string key;
+            if (!string(key) || !expect(':')) return false;
+            bool ok;
+            if (key == "name") ok = string(t.name);
+            else if (key == "initial") ok = state(t.initial);
+            else if (key == "final") ok = state(t.final);
+            else if (key == "cycles") ok = tuples([&](uint16_t a, uint8_t d, const std::string &kind) {
+                t.cycles.push_back({a, d, kind == "write"});
+            });
+            else ok = skip_value();
+            if (!ok) return false;
+        } while (expect(','));
+        return expect('}');
+    }
+};
+
+static bool load_vectors(const std::string &filename, std::vector<test_vector> &tests) {
+    FILE *f = fopen(filename.c_str(), "rb");
+    if (f == NULL) return false;
+    std::string text;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    fclose(f);
+
+    json_reader r { text.data(), text.data() + text.size() };
+    if (!r.expect('[')) return false;
+    if (r.expect(']')) return true;
+    do {
+        tests.emplace_back();
+        if (!r.test(tests.back())) return false;
+    } while (r.expect(','));
+    return r.expect(']');
+}
+
+/**
+ * Running.
+ */
+struct core_type {
+    const char *name;
+    execute_next_fn execute_next;
+};
+
+struct job {
+    const core_type *core;
+    std::string filename;
+    int opcode;
+
+    uint64_t total = 0;
+    uint64_t passed = 0;
+    uint64_t cycle_mismatches = 0;
+    bool load_failed = false;
+    std::string first_failure;
+};
+
+static bool strict_cycles = false;
+
+static void append(std::string &out, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void append(std::string &out, const char *fmt, ...) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    out += buf;
+}
+
+static std::string describe_failure(const test_vector &t, cpu_state *cpu, uint64_t cycles) {
+    std::string d;
+    const vector_state &e = t.final;
+    append(d, "  test \"%s\"\n", t.name.c_str());
+    append(d, "           PC   S  A  X  Y  P\n");
+    append(d, "  expected %04X %02X %02X %02X %02X %02X\n", e.pc, e.s, e.a, e.x, e.y, e.p);
+    append(d, "  got      %04X %02X %02X %02X %02X %02X\n", cpu->pc, (uint8_t)cpu->sp, cpu->a_lo, cpu->x_lo, cpu->y_lo, cpu->p);
+    for (const auto &m : e.ram) {
+        if (flat_ram[m.first] != m.second) {
+            append(d, "  ram[$%04X] expected %02X got %02X\n", m.first, m.second, flat_ram[m.first]);
+        }
+    }
+    append(d, "  cycles expected %zu got %llu\n", t.cycles.size(), (unsigned long long)cycles);
+    size_t n = std::max(t.cycles.size(), bus_log->size());
+    for (size_t i = 0; i < n; i++) {
+        std::string left = "", right = "";
+        if (i < t.cycles.size()) append(left, "%04X %02X %s", t.cycles[i].address, t.cycles[i].value, t.cycles[i].write ? "write" : "read ");
+        if (i < bus_log->size()) append(right, "%04X %02X %s", (*bus_log)[i].address, (*bus_log)[i].value, (*bus_log)[i].write ? "write" : "read ");
+        append(d, "    %-16s | %s\n", left.c_str(), right.c_str());
+    }
+    return d;
+}
+
+static void run_job(job &j, cpu_state *cpu) {
+    std::vector<test_vector> tests;
+    tests.reserve(10000);
+    if (!load_vectors(j.filename, tests)) {
+        j.load_failed = true;
+        return;
+    }
+
+    for (const test_vector &t : tests) {
+        const vector_state &in = t.initial;
+        cpu->pc = in.pc;
+        cpu->sp = in.s;
+        cpu->a = in.a;
+        cpu->x = in.x;
+        cpu->y = in.y;
+        cpu->p = in.p;
+        cpu->cycles = 0;
+        cpu->halt = 0;
+        cpu->irq_asserted = 0;
+        for (const auto &m : in.ram) flat_ram[m.first] = m.second;
+        bus_log->clear();
+
+        (j.core->execute_next)(cpu);
+
+        const vector_state &e = t.final;
+        bool ok = cpu->pc == e.pc && (uint8_t)cpu->sp == e.s && cpu->a_lo == e.a
+            && cpu->x_lo == e.x && cpu->y_lo == e.y && cpu->p == e.p;
+        for (const auto &m : e.ram) {
+            if (flat_ram[m.first] != m.second) ok = false;
+        }
+        bool cycles_ok = cpu->cycles == t.cycles.size();
+        if (!cycles_ok) j.cycle_mismatches++;
+        if (strict_cycles && !cycles_ok) ok = false;
+
+        j.total++;
+        if (ok) j.passed++;
+        else if (j.first_failure.empty()) j.first_failure = describe_failure(t, cpu, cpu->cycles);
+
+        /* put RAM back to all zeroes for the next test */
+        for (const auto &m : in.ram) flat_ram[m.first] = 0;
+        for (const bus_access &b : *bus_log) flat_ram[b.address] = 0;
+    }
+}
+
+static void worker(std::vector<job> &jobs, std::atomic<size_t> &next) {
+    std::vector<uint8_t> ram(0x10000, 0);
+    std::vector<bus_access> log;
+    log.reserve(64);
+    flat_ram = ram.data();
+    bus_log = &log;
+    cpu_state *cpu = new cpu_state();
+
+    size_t i;
+    while ((i = next.fetch_add(1)) < jobs.size()) {
+        run_job(jobs[i], cpu);
+    }
+    delete cpu;
+}
+
+static const core_type core_6502 = { "6502", cpu_6502::execute_next };
+static const core_type core_65c02 = { "65c02", cpu_65c02::execute_next };
+
+static void add_jobs(std::vector<job> &jobs, const core_type *core, const char *dir, const std::vector<bool> &opcodes) {
+    for (int op = 0; op < 256; op++) {
+        if (!opcodes[op]) continue;
+        char name[16];
+        snprintf(name, sizeof(name), "%02x.json", op);
+        std::filesystem::path path = std::filesystem::path(dir) / name;
+        if (!std::filesystem::exists(path)) continue;
+        job j;
+        j.core = core;
+        j.filename = path.string();
+        j.opcode = op;
+        jobs.push_back(j);
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-6 6502_dir] [-C 65c02_dir] [-j threads] [-o op,op,...] [-x] [-q]\n", prog);
+    fprintf(stderr, "  -6 / -C  directories of 00.json .. ff.json vectors for each core\n");
+    fprintf(stderr, "  -o       only these opcodes (hex)\n");
+    fprintf(stderr, "  -x       cycle count mismatches fail the test\n");
+    fprintf(stderr, "  -q       only print opcodes with failures\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *dir_6502 = nullptr;
+    const char *dir_65c02 = nullptr;
+    unsigned threads = std::thread::hardware_concurrency();
+    std::vector<bool> opcodes(256, true);
+    bool quiet = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "6:C:j:o:xq")) != -1) {
+        switch (opt) {
+            case '6':
+                dir_6502 = optarg;
+                break;
+            case 'C':
+                dir_65c02 = optarg;
+                break;
+            case 'j':
+                threads = atoi(optarg);
+                break;
+            case 'o': {
+                std::fill(opcodes.begin(), opcodes.end(), false);
+                char *s = optarg;
+                while (*s) {
+                    char *after;
+                    long op = strtol(s, &after, 16);
+                    if (after == s || op < 0 || op > 0xFF) {
+                        fprintf(stderr, "Bad opcode list: %s\n", optarg);
+                        return 2;
+                    }
+                    opcodes[op] = true;
+                    s = (*after == ',') ? after + 1 : after;
+                }
+                break;
+            }
+            case 'x':
+                strict_cycles = true;
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (dir_6502 == nullptr && dir_65c02 == nullptr) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (threads == 0) threads = 1;
+
+    std::vector<job> jobs;
+    if (dir_6502) add_jobs(jobs, &core_6502, dir_6502, opcodes);
+    if (dir_65c02) add_jobs(jobs, &core_65c02, dir_65c02, opcodes);
+    if (jobs.empty()) {
+        fprintf(stderr, "No vector files found\n");
+        return 2;
+    }
+    /* biggest files first, so one slow straggler doesn't hold up the end of the run */
+    std::stable_sort(jobs.begin(), jobs.end(), [](const job &a, const job &b) {
+        return std::filesystem::file_size(a.filename) > std::filesystem::file_size(b.filename);
+    });
+    threads = std::min<size_t>(threads, jobs.size());
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next { 0 };
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < threads; i++) {
+        pool.emplace_back(worker, std::ref(jobs), std::ref(next));
+    }
+    for (std::thread &t : pool) t.join();
+    auto end = std::chrono::steady_clock::now();
+
+    std::sort(jobs.begin(), jobs.end(), [](const job &a, const job &b) {
+        if (a.core != b.core) return a.core == &core_6502;
+        return a.opcode < b.opcode;
+    });
+
+    uint64_t total = 0, passed = 0, cycle_mismatches = 0;
+    int failed_files = 0;
+    for (const job &j : jobs) {
+        total += j.total;
+        passed += j.passed;
+        cycle_mismatches += j.cycle_mismatches;
+        bool failed = j.load_failed || j.passed != j.total;
+        if (failed) failed_files++;
+        if (quiet && !failed) continue;
+
+        if (j.load_failed) {
+            printf("%-5s %02X: could not parse %s\n", j.core->name, j.opcode, j.filename.c_str());
+            continue;
+        }
+        printf("%-5s %02X: %6llu / %6llu passed", j.core->name, j.opcode,
+            (unsigned long long)j.passed, (unsigned long long)j.total);
+        if (j.cycle_mismatches) printf("  (%llu cycle count mismatches)", (unsigned long long)j.cycle_mismatches);
+        printf("\n");
+        if (!j.first_failure.empty()) printf("%s", j.first_failure.c_str());
+    }
+
+    double secs = std::chrono::duration<double>(end - start).count();
+    printf("\n%llu / %llu vectors passed, %d opcode files with failures, %llu cycle count mismatches\n",
+        (unsigned long long)passed, (unsigned long long)total, failed_files, (unsigned long long)cycle_mismatches);
+    printf("%.2f s on %u threads (%.0f vectors/s)\n", secs, threads, secs > 0 ? total / secs : 0.0);
+
+    return failed_files ? 1 : 0;
+}
@@ -23,6 +23,7 @@
 #include "memory.hpp"
 #include "display/text_40x24.hpp"
 #include "display/hgr_280x192.hpp"
+#include "display/video_scanner.hpp"
 /**
  * Process read and write to simulated IO bus for peripherals 
  * All external bus accesses are 8-bit data, 16-bit address.
@@ -53,12 +54,27 @@ void register_C0xx_memory_write_handler(uint16_t address, memory_write_handler h
     C0xx_memory_write_handlers[address - C0X0_BASE] = handler;
 }
 
+/* For devices that sit in front of another device's switch and pass it through. */
+memory_read_handler get_C0xx_memory_read_handler(uint16_t address) {
+    if (address < C0X0_BASE || address >= C0X0_BASE + C0X0_SIZE) {
+        return nullptr;
+    }
+    return C0xx_memory_read_handlers[address - C0X0_BASE];
+}
+
+memory_write_handler get_C0xx_memory_write_handler(uint16_t address) {
+    if (address < C0X0_BASE || address >= C0X0_BASE + C0X0_SIZE) {
+        return nullptr;
+    }
+    return C0xx_memory_write_handlers[address - C0X0_BASE];
+}
+
 uint8_t memory_bus_read(cpu_state *cpu, uint16_t address) {
     if (address >= C0X0_BASE && address < C0X0_BASE + C0X0_SIZE) {
         memory_read_handler funcptr =  C0xx_memory_read_handlers[address - C0X0_BASE];
         if (funcptr != nullptr) {
             return (*funcptr)(cpu, address);
-        } else return 0xEE;
+        } else return floating_bus_read(cpu); // nothing drives the bus; whatever the video fetched is still on it
     }
     if (address >= 0xC100 && address < 0xC800) { // Slot-card firmware.
         uint8_t slot = (address / 0x100) & 0x7;
@@ -69,28 +85,23 @@ uint8_t memory_bus_read(cpu_state *cpu, uint16_t address) {
     }
     /* Identifcal with what's in memory_bus_write */
     if (address == 0xCFFF) {
-        cpu->C8xx_slot = 0xFF;
-        for (uint8_t page = 0; page < 8; page++) {
-            memory_map_page_both(cpu, page + 0xC8, cpu->main_io_4 + (page + 0x08) * 0x100, MEM_IO);
-        }
+        release_C8xx(cpu);
         return raw_memory_read(cpu, address);
     }
     return cpu->memory->pages_read[address / GS2_PAGE_SIZE][address % GS2_PAGE_SIZE];
-//    return 0xEE; /* TODO: should return a random value 'floating bus'*/
 }
 
 void memory_bus_write(cpu_state *cpu, uint16_t address, uint8_t value) {
-    if (address >= 0x0400 && address <= 0x0BFF) {
-        txt_memory_write(cpu, address, value);
-    }
-    if (address >= 0x2000 && address <= 0x5FFF) {
-        hgr_memory_write(cpu, address, value);
+    switch (cpu->memory->video_observer[address / GS2_PAGE_SIZE]) {
+        case VIDEO_OBSERVER_TEXT:
+            txt_memory_write(cpu, address, value);
+            return;
+        case VIDEO_OBSERVER_HGR:
+            hgr_memory_write(cpu, address, value);
+            return;
     }
     if (address == 0xCFFF) {
-        cpu->C8xx_slot = 0xFF;
-        for (uint8_t page = 0; page < 8; page++) {
-            memory_map_page_both(cpu, page + 0xC8, cpu->main_io_4 + (page + 0x08) * 0x100, MEM_IO);
-        }
+        release_C8xx(cpu);
         return;
     }
     if (address >= C0X0_BASE && address < C0X0_BASE + C0X0_SIZE) {
@@ -29,3 +29,5 @@ void memory_bus_write(cpu_state *cpu, uint16_t address, uint8_t value);
 
 void register_C0xx_memory_read_handler(uint16_t address, memory_read_handler handler);
 void register_C0xx_memory_write_handler(uint16_t address, memory_write_handler handler);
+memory_read_handler get_C0xx_memory_read_handler(uint16_t address);
+memory_write_handler get_C0xx_memory_write_handler(uint16_t address);
@@ -112,4 +112,17 @@ void *get_module_state(cpu_state *cpu, module_id_t module_id) {
 
 void set_module_state(cpu_state *cpu, module_id_t module_id, void *state) {
     cpu->module_store[module_id] = state;
-}
\ No newline at end of file
+}
+
+/**
+ * Devices assert /IRQ by source (usually their slot number). The CPU
+ * takes the interrupt before the next opcode fetch if any source is
+ * asserted and I is clear. Device must deassert when serviced.
+ */
+void cpu_set_irq(cpu_state *cpu, int source, bool asserted) {
+    if (asserted) {
+        cpu->irq_asserted |= (1 << source);
+    } else {
+        cpu->irq_asserted &= ~(1 << source);
+    }
+}
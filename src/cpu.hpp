@@ -18,8 +18,6 @@
 #pragma once
 
 #include <stdint.h>
-//#include <SDL3/SDL.h>
-#include <SDL3/SDL.h>
 
 #include "memoryspecs.hpp"
 #include "clock.hpp"
@@ -43,6 +41,13 @@ enum memory_type {
     MEM_IO,
 };
 
+/* Which display hook a RAM write to the page has to go through, if any. */
+enum video_observer {
+    VIDEO_OBSERVER_NONE = 0,
+    VIDEO_OBSERVER_TEXT,    // text / lores page on screen
+    VIDEO_OBSERVER_HGR,     // hires page on screen
+};
+
 struct memory_page_info {
     uint16_t start_address;
     uint16_t end_address;
@@ -55,6 +60,7 @@ struct memory_map {
     memory_page_info page_info[MEMORY_SIZE / GS2_PAGE_SIZE];
     uint8_t *pages_read[MEMORY_SIZE / GS2_PAGE_SIZE];
     uint8_t *pages_write[MEMORY_SIZE / GS2_PAGE_SIZE];
+    uint8_t video_observer[MEMORY_SIZE / GS2_PAGE_SIZE]; // video_observer, kept current by the display
     //memory_page *pages[MEMORY_SIZE / GS2_PAGE_SIZE];
 };
 
@@ -64,6 +70,8 @@ enum processor_type {
     NUM_PROCESSOR_TYPES
 };
 
+#define MAX_RESET_HANDLERS 16
+
 // a couple forward declarations
 struct cpu_state;
 class Mounts;
@@ -94,6 +102,8 @@ typedef enum {
     MODULE_THUNDERCLOCK,
     MODULE_PRODOS_CLOCK,
     MODULE_PD_BLOCK2,
+    MODULE_MOUSE,
+    MODULE_IIE_MEMORY,
     MODULE_NUM_MODULES
 } module_id_t;
 
@@ -174,16 +184,22 @@ struct cpu_state {
         uint8_t p;  /* Processor Status Register */
     };
     uint8_t halt = 0; /* == 1 is HLT instruction halt; == 2 is user halt */
+    uint32_t irq_asserted = 0; /* one bit per device holding /IRQ low. Wired-OR, like the real bus. */
     uint64_t cycles; /* Number of cycles since reset */
 
     uint8_t *main_ram_64 = nullptr;
     uint8_t *main_io_4 = nullptr;
     uint8_t *main_rom_D0 = nullptr;
+    uint8_t *main_rom_C0 = nullptr; /* IIe internal $C000-$CFFF ROM. nullptr on machines without it. */
+    uint8_t *aux_ram_64 = nullptr; /* IIe auxiliary 64K. nullptr on machines without it. */
 
     memory_map *memory;
+    memory_map *reset_memory = nullptr; /* the default map as built at power-on. a reset copies it back. */
 
-    int8_t C8xx_slot;
+    uint8_t C8xx_slot;      /* slot whose $C800 ROM is mapped in, 0xFF for none */
     void (*C8xx_handlers[8])(cpu_state *cpu) = {nullptr};
+    uint8_t *C8xx_rom_pages[8][8] = {{nullptr}}; /* per slot, the 8 page pointers for its $C800-$CFFF ROM. built once at register time. */
+    uint8_t *C8xx_idle_pages[8] = {nullptr};     /* what $C800-$CFFF shows with no slot selected */
 
     uint64_t last_tick;
     uint64_t next_tick;
@@ -199,6 +215,10 @@ struct cpu_state {
 
     Mounts *mounts;
 
+    /* devices that have something to do on RESET. run by system_reset in registration (device init) order. */
+    void (*reset_handlers[MAX_RESET_HANDLERS])(cpu_state *cpu) = {nullptr};
+    int num_reset_handlers = 0;
+
     void *module_store[MODULE_NUM_MODULES];
 };
 
@@ -231,3 +251,5 @@ const char* processor_get_name(int processor_type);
 void *get_module_state(cpu_state *cpu, module_id_t module_id);
 
 void set_module_state(cpu_state *cpu, module_id_t module_id, void *state);
+
+void cpu_set_irq(cpu_state *cpu, int source, bool asserted);
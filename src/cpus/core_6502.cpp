@@ -70,6 +70,11 @@ int execute_next(cpu_state *cpu) {
 
     if (DEBUG(DEBUG_REGISTERS)) fprintf(stdout, " | PC: $%04X, A: $%02X, X: $%02X, Y: $%02X, P: $%02X, S: $%02X || ", cpu->pc, cpu->a_lo, cpu->x_lo, cpu->y_lo, cpu->p, cpu->sp);
 
+    if (cpu->irq_asserted && !(cpu->p & FLAG_I)) {
+        take_irq(cpu);
+        return 0;
+    }
+
     if (DEBUG(DEBUG_OPCODE)) fprintf(stdout, "%04X: ", cpu->pc); // so PC is correct.
     opcode_t opcode = read_byte_from_pc(cpu);
     if (DEBUG(DEBUG_OPCODE)) fprintf(stdout, "%s", get_opcode_name(opcode));
@@ -22,8 +22,12 @@
  */
 
 
+/**
+ * monotonic, and no SDL dependency, so the cores can be linked into headless tools.
+ */
 uint64_t get_current_time_in_microseconds() {
-    return SDL_GetTicksNS() / 1000;
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 /**
@@ -47,23 +51,94 @@ inline void set_n_z_v_flags(cpu_state *cpu, uint8_t value, uint8_t N) {
 }
 
 /**
- * Convert a binary-coded decimal byte to an integer.
- * Each nibble represents a decimal digit (0-9).
+ * Decimal mode ADC / SBC, precomputed for every carry, A and operand, invalid
+ * BCD included. Each entry is the result in the low byte and the flags in the
+ * high byte. This header is compiled once per CPU namespace, so the 6502 and
+ * the 65C02 each get their own tables built with their own flag rules.
+ *
+ * The rules are from Bruce Clark's "Decimal Mode" tutorial on 6502.org:
+ * NMOS ADC takes N and V from the sum before the high digit is adjusted and Z
+ * from the binary sum; NMOS SBC sets all its flags the same as in binary mode.
+ * The 65C02 fixed N and Z to match the result it stores.
  */
-inline uint8_t bcd_to_int(byte_t bcd) {
-    return ((bcd >> 4) * 10) + (bcd & 0x0F);
-}
+#define DECIMAL_C 0x0100
+#define DECIMAL_Z 0x0200
+#define DECIMAL_V 0x0400
+#define DECIMAL_N 0x0800
+
+static uint16_t decimal_adc_table[2][256][256];
+static uint16_t decimal_sbc_table[2][256][256];
+
+inline uint16_t decimal_adc(uint8_t C, uint8_t A, uint8_t B) {
+    int AL = (A & 0x0F) + (B & 0x0F) + C;
+    if (AL >= 0x0A) AL = ((AL + 0x06) & 0x0F) + 0x10;
+    int S = (A & 0xF0) + (B & 0xF0) + AL;         // N and V come from here, before the high digit adjust
+    int SS = (int8_t)(A & 0xF0) + (int8_t)(B & 0xF0) + AL;
+    if (S >= 0xA0) S += 0x60;
+    uint8_t result = (uint8_t)S;
+
+    uint16_t flags = 0;
+    if (S >= 0x100) flags |= DECIMAL_C;
+    if (SS < -128 || SS > 127) flags |= DECIMAL_V;
+#ifdef CPU_65C02
+    if (result == 0) flags |= DECIMAL_Z;
+    if (result & 0x80) flags |= DECIMAL_N;
+#else
+    if ((uint8_t)(A + B + C) == 0) flags |= DECIMAL_Z;
+    if (((A & 0xF0) + (B & 0xF0) + AL) & 0x80) flags |= DECIMAL_N;
+#endif
+    return flags | result;
+}
+
+inline uint16_t decimal_sbc(uint8_t C, uint8_t A, uint8_t B) {
+    // carry, overflow (and on NMOS, N and Z) are exactly what binary SBC gives.
+    int binary = A + (B ^ 0xFF) + C;
+    uint8_t B1 = B ^ 0xFF;
+    uint16_t flags = 0;
+    if (binary & 0x100) flags |= DECIMAL_C;
+    if (!((A ^ B1) & 0x80) && ((A ^ binary) & 0x80)) flags |= DECIMAL_V;
+
+    int AL = (A & 0x0F) - (B & 0x0F) + C - 1;
+#ifdef CPU_65C02
+    int S = A - B + C - 1;
+    if (S < 0) S -= 0x60;
+    if (AL < 0) S -= 0x06;
+    uint8_t result = (uint8_t)S;
+    if (result == 0) flags |= DECIMAL_Z;
+    if (result & 0x80) flags |= DECIMAL_N;
+#else
+    if (AL < 0) AL = ((AL - 0x06) & 0x0F) - 0x10;
+    int S = (A & 0xF0) - (B & 0xF0) + AL;
+    if (S < 0) S -= 0x60;
+    uint8_t result = (uint8_t)S;
+    if ((uint8_t)binary == 0) flags |= DECIMAL_Z;
+    if (binary & 0x80) flags |= DECIMAL_N;
+#endif
+    return flags | result;
+}
+
+/* 512K per CPU variant, filled in before main() runs. */
+static struct decimal_tables_init_t {
+    decimal_tables_init_t() {
+        for (int c = 0; c < 2; c++) {
+            for (int a = 0; a < 256; a++) {
+                for (int b = 0; b < 256; b++) {
+                    decimal_adc_table[c][a][b] = decimal_adc(c, a, b);
+                    decimal_sbc_table[c][a][b] = decimal_sbc(c, a, b);
+                }
+            }
+        }
+    }
+} decimal_tables_init;
 
-/**
- * Convert an integer (0-99) to binary-coded decimal format.
- * Returns a byte with each nibble representing a decimal digit.
- */
-inline byte_t int_to_bcd(uint8_t n) {
-    uint8_t n1 = n % 100;
-    return ((n1 / 10) << 4) | (n1 % 10);
+inline void set_decimal_result(cpu_state *cpu, uint16_t entry) {
+    cpu->a_lo = (uint8_t)entry;
+    cpu->C = (entry & DECIMAL_C) != 0;
+    cpu->Z = (entry & DECIMAL_Z) != 0;
+    cpu->V = (entry & DECIMAL_V) != 0;
+    cpu->N = (entry & DECIMAL_N) != 0;
 }
 
-
 /**
  * perform accumulator addition. M is current value of accumulator. 
  * cpu: cpu flag
@@ -80,12 +155,8 @@ inline void add_and_set_flags(cpu_state *cpu, uint8_t N) {
         set_n_z_flags(cpu, cpu->a_lo);
         if (DEBUG(DEBUG_REGISTERS)) fprintf(stdout, "   M: %02X  N: %02X  S: %02X  C: %02X  V: %02X", M, N, cpu->a_lo, cpu->C, cpu->V);
     } else {              // decimal mode
-        uint8_t M = bcd_to_int(cpu->a_lo);
-        uint8_t N1 = bcd_to_int(N);
-        uint8_t S8 = M + N1 + cpu->C;
-        cpu->a_lo = int_to_bcd(S8);
-        cpu->C = (S8 > 99);
-        set_n_z_flags(cpu, cpu->a_lo);
+        uint8_t M = cpu->a_lo;
+        set_decimal_result(cpu, decimal_adc_table[cpu->C][M][N]);
         if (DEBUG(DEBUG_REGISTERS)) fprintf(stdout, "   M: %02X  N: %02X  S: %02X  C: %02X  V: %02X", M, N, cpu->a_lo, cpu->C, cpu->V);
     }
 }
@@ -123,18 +194,9 @@ inline void subtract_and_set_flags(cpu_state *cpu, uint8_t N) {
         set_n_z_flags(cpu, S8);
         if (DEBUG(DEBUG_REGISTERS)) fprintf(stdout, "   M: %02X  N: %02X  S: %02X  Z:%01X C:%01X N:%01X V:%01X ", M, N, S8, cpu->Z, cpu->C, cpu->N, cpu->V);
     } else {
-        uint8_t M = bcd_to_int(cpu->a_lo);
-        uint8_t N1 = bcd_to_int(N);
-        int8_t S8 = M - N1 - !C;
-        if (S8 < 0) {
-            S8 += 100;
-            cpu->C = 0; // c = 0 indicates a borrow in subtraction
-        } else {
-            cpu->C = 1;
-        }
-        cpu->a_lo = int_to_bcd(S8);
-        set_n_z_flags(cpu, cpu->a_lo);
-        if (DEBUG(DEBUG_REGISTERS)) fprintf(stdout, "   M: %02X  N: %02X  S: %02X  Z:%01X C:%01X N:%01X V:%01X ", M, N, S8, cpu->Z, cpu->C, cpu->N, cpu->V);
+        uint8_t M = cpu->a_lo;
+        set_decimal_result(cpu, decimal_sbc_table[C][M][N]);
+        if (DEBUG(DEBUG_REGISTERS)) fprintf(stdout, "   M: %02X  N: %02X  S: %02X  Z:%01X C:%01X N:%01X V:%01X ", M, N, cpu->a_lo, cpu->Z, cpu->C, cpu->N, cpu->V);
     }
 }
 
@@ -581,6 +643,23 @@ inline void push_word(cpu_state *cpu, word_t N) {
     if (DEBUG(DEBUG_OPCODE)) fprintf(stdout, " [#%04X] -> S[0x01 %02X]", N, cpu->sp + 1);
 }
 
+/**
+ * Hardware IRQ. Same stack frame as BRK, except B is clear and the PC
+ * pushed is the next instruction (no 'mark' byte).
+ */
+inline void take_irq(cpu_state *cpu) {
+    incr_cycles(cpu);
+    incr_cycles(cpu);
+    push_word(cpu, cpu->pc);
+    push_byte(cpu, (cpu->p & ~FLAG_B) | FLAG_UNUSED);
+    cpu->p |= FLAG_I;
+#ifdef CPU_65C02
+    cpu->p &= ~FLAG_D; // 65C02 clears decimal mode on interrupt. NMOS leaves it alone.
+#endif
+    cpu->pc = read_word(cpu, IRQ_VECTOR);
+    if (DEBUG(DEBUG_OPCODE)) fprintf(stdout, "IRQ => $%04X\n", cpu->pc);
+}
+
 inline absaddr_t pop_word(cpu_state *cpu) {
     absaddr_t N = read_word(cpu, 0x0100 + cpu->sp + 1);
     cpu->sp = (uint8_t)(cpu->sp + 2);
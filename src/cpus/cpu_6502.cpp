@@ -16,6 +16,7 @@
  */
 
 #include <iostream>
+#include <chrono>
 #include <cstdio>
 #include <unistd.h>
 #include <sstream>
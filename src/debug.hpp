@@ -38,6 +38,8 @@ extern uint64_t debug_level;
 #define DEBUG_DISKII_FORMAT 0x10000
 #define DEBUG_THUNDERCLOCK 0x20000
 #define DEBUG_PD_BLOCK 0x40000
+#define DEBUG_MOUSE 0x80000
+#define DEBUG_IIE_MEMORY 0x100000
 
 #define DEBUG_ANY 0xFFFFFFFF
 #define DEBUG_BOOT_FLAG 0 /* DEBUG_DISKII */
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include "devices.hpp"
 
 #include "devices/keyboard/keyboard.hpp"
@@ -11,6 +13,8 @@
 #include "devices/memoryexpansion/memexp.hpp"
 #include "devices/thunderclock_plus/thunderclockplus.hpp"
 #include "devices/pdblock2/pdblock2.hpp"
+#include "devices/mouse/mouse.hpp"
+#include "devices/iiememory/iiememory.hpp"
 
 Device_t NoDevice = {
         DEVICE_ID_END,
@@ -36,7 +40,7 @@ Device_t Devices[NUM_DEVICE_IDS] = {
         DEVICE_ID_SPEAKER,
         "Speaker",
         init_mb_speaker,
-        NULL
+        power_off_speaker
     },
     {
         DEVICE_ID_DISPLAY,
@@ -72,13 +76,22 @@ Device_t Devices[NUM_DEVICE_IDS] = {
         DEVICE_ID_DISK_II,
         "Disk II Controller",
         init_slot_diskII,
-        NULL
+        NULL,
+        diskii_prepare_media,
+        mount_diskII,
+        unmount_diskII,
+        diskii_status
     },
     {
         DEVICE_ID_MEM_EXPANSION,
         "Memory Expansion (Slinky)",
         init_slot_memexp,
-        NULL
+        power_off_memexp,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        memexp_set_option
     },
     {
         DEVICE_ID_THUNDER_CLOCK,
@@ -90,6 +103,22 @@ Device_t Devices[NUM_DEVICE_IDS] = {
         DEVICE_ID_PD_BLOCK2,
         "Generic ProDOS Block 2",
         init_pdblock2,
+        NULL,
+        NULL,
+        mount_pdblock2,
+        unmount_pdblock2,
+        pdblock2_osd_status
+    },
+    {
+        DEVICE_ID_MOUSE,
+        "Apple Mouse Interface",
+        init_slot_mouse,
+        NULL
+    },
+    {
+        DEVICE_ID_IIE_MEMORY,
+        "Apple IIe Memory (aux RAM / MMU)",
+        init_mb_iie_memory,
         NULL
     },
 };
@@ -97,3 +126,29 @@ Device_t Devices[NUM_DEVICE_IDS] = {
 Device_t *get_device(device_id id) {
     return &Devices[id-1];
 }
+
+static const DeviceKey_t DeviceKeys[] = {
+    { "keyboard_iiplus", DEVICE_ID_KEYBOARD_IIPLUS, false, false },
+    { "keyboard_iie",    DEVICE_ID_KEYBOARD_IIE,    false, false },
+    { "speaker",         DEVICE_ID_SPEAKER,         false, false },
+    { "display",         DEVICE_ID_DISPLAY,         false, false },
+    { "gamecontroller",  DEVICE_ID_GAMECONTROLLER,  false, false },
+    { "languagecard",    DEVICE_ID_LANGUAGE_CARD,   true,  false },
+    { "prodos_block",    DEVICE_ID_PRODOS_BLOCK,    true,  false },
+    { "prodos_clock",    DEVICE_ID_PRODOS_CLOCK,    true,  false },
+    { "diskii",          DEVICE_ID_DISK_II,         true,  true },
+    { "memexp",          DEVICE_ID_MEM_EXPANSION,   true,  false },
+    { "thunderclock",    DEVICE_ID_THUNDER_CLOCK,   true,  false },
+    { "pdblock2",        DEVICE_ID_PD_BLOCK2,       true,  true },
+    { "mouse",           DEVICE_ID_MOUSE,           true,  false },
+    { "iie_memory",      DEVICE_ID_IIE_MEMORY,      false, false },
+};
+
+const DeviceKey_t *find_device_key(const char *key) {
+    for (size_t i = 0; i < sizeof(DeviceKeys) / sizeof(DeviceKeys[0]); i++) {
+        if (strcmp(DeviceKeys[i].key, key) == 0) {
+            return &DeviceKeys[i];
+        }
+    }
+    return nullptr;
+}
@@ -2,6 +2,8 @@
 
 #include "gs2.hpp"
 #include "cpu.hpp"
+#include "util/media.hpp"
+#include "util/drive_events.hpp"
 
 typedef enum device_id {
     DEVICE_ID_END = 0,
@@ -17,6 +19,8 @@ typedef enum device_id {
     DEVICE_ID_MEM_EXPANSION,
     DEVICE_ID_THUNDER_CLOCK,
     DEVICE_ID_PD_BLOCK2,
+    DEVICE_ID_MOUSE,
+    DEVICE_ID_IIE_MEMORY,
     NUM_DEVICE_IDS
 } device_id;
 
@@ -30,8 +34,40 @@ struct Device_t {
     const char *name;
     void (*power_on)(cpu_state *cpu, SlotType_t slot_number);
     void (*power_off)(cpu_state *cpu, SlotType_t slot_number);
+
+    /**
+     * Storage controllers only; Mounts dispatches through these for whatever
+     * card is in the slot. prepare_media is optional, runs on the mount worker
+     * thread, and must not touch device state. mount returns 0 on success.
+     */
+    int (*prepare_media)(media_descriptor *media);
+    int (*mount)(cpu_state *cpu, uint8_t slot, uint8_t drive, media_descriptor *media);
+    void (*unmount)(cpu_state *cpu, uint8_t slot, uint8_t drive);
+    drive_status_t (*media_status)(cpu_state *cpu, uint64_t key);
+
+    /**
+     * Optional. One setting for the card in a slot, from a [slotN] section of
+     * a system config file. Runs before power_on. Returns false if it doesn't
+     * take that key or value.
+     */
+    bool (*set_option)(SlotType_t slot, const char *key, const char *value);
 };
 
 Device_t *get_device(device_id id);
 
+/**
+ * The names system config files (-C) use for devices, and where each one
+ * goes: in a slot, or on the motherboard. multiple is for the cards that keep
+ * their state per slot; everything else keeps one module state for the whole
+ * machine, so a second one would stomp on the first.
+ */
+struct DeviceKey_t {
+    const char *key;
+    device_id id;
+    bool slot_card;
+    bool multiple;
+};
+
+const DeviceKey_t *find_device_key(const char *key);
+
 extern Device_t NoDevice;
@@ -168,6 +168,7 @@ In DOS at $B800 lives the "prenibble routine" . I could perhaps steal that. hehe
 #include "devices/diskii/diskii_fmt.hpp"
 #include "debug.hpp"
 #include "util/mount.hpp"
+#include "util/reset.hpp"
 
 /* uint8_t diskII_firmware[256] = {
  0xA2,  0x20,  0xA0,  0x00,   0xA2,  0x03,  0x86,  0x3C,   0x8A,  0x0A,  0x24,  0x3C,   0xF0,  0x10,  0x05,  0x3C,  
@@ -188,35 +189,37 @@ In DOS at $B800 lives the "prenibble routine" . I could perhaps steal that. hehe
  0x3D,  0xCD,  0x00,  0x08,   0xA6,  0x2B,  0x90,  0xDB,   0x4C,  0x01,  0x08,  0x00,   0x00,  0x00,  0x00,  0x00,  
 }; */
 
+/* what an empty drive spins: every track empty. */
+static nibblized_disk_t diskii_no_disk;
+
 struct diskII {
-    uint8_t rw_mode; // 0 = read, 1 = write
-    int8_t track;
-    uint8_t phase0;
-    uint8_t phase1;
-    uint8_t phase2;
-    uint8_t phase3;
-    uint8_t last_phase_on;
-    bool motor;
+    uint8_t rw_mode = 0; // 0 = read, 1 = write
+    int8_t track = 0;
+    uint8_t phase0 = 0;
+    uint8_t phase1 = 0;
+    uint8_t phase2 = 0;
+    uint8_t phase3 = 0;
+    uint8_t last_phase_on = 0;
+    bool motor = false;
     uint8_t Q7 = 0;
     uint8_t Q6 = 0;
     uint8_t write_protect = 0; // 1 = write protect, 0 = not write protect
     uint16_t image_index = 0;
-    uint16_t head_position = 0; // index into the track
-    uint8_t bit_position = 0; // how many bits left in byte.
-    uint8_t read_shift_register = 0; // when bit position = 0, this is 0. As bit_position increments, we shift in the next bit of the byte at head_position.
-    uint64_t last_read_cycle = 0;
+    uint16_t head_position = 0; // index into the track. Only authoritative while the motor is stopped.
+    uint8_t read_shift_register = 0; // last value seen on the data latch; returned while the motor is stopped.
+    uint64_t spin_base_cycle = 0; // cpu cycle at which nybble 0 was (virtually) under the head. Only meaningful while the motor runs.
 
     uint64_t mark_cycles_turnoff = 0; // when DRIVES OFF, set this to current cpu cycles. Then don't actually set motor=0 until one second (1M cycles) has passed. Then reset this to 0.
 
     bool is_mounted = false;
-    disk_image_t media;
-    nibblized_disk_t nibblized;
-    media_descriptor *media_d;
+    nibblized_disk_t *nibblized = &diskii_no_disk; // owned by media_d while mounted
+    media_descriptor *media_d = nullptr;
 };
 
 struct diskII_controller {
     diskII drive[2];
-    uint8_t drive_select;
+    uint8_t drive_select = 0;
+    bool installed = false; // a Disk II card was powered on in this slot
 };
 
 //diskII_controller diskII_slot[8]; // slots 0-7. We'll never use 0 etc.
@@ -225,90 +228,145 @@ struct diskII_controller {
 #define DEBUG_MOT(slot, drive, onoff) fprintf(stdout, "slot %d, drive %d, motor %d \n", slot, drive, onoff)
 #define DEBUG_DS(slot, drive, onoff) fprintf(stdout, "slot %d, drive %d, drive_select %d \n", slot, drive, onoff)
 
-uint8_t read_nybble(diskII& disk) { // cause a shift.
+/**
+ * The disk turns at a fixed rate: one nybble passes under the head every 32 cpu cycles.
+ * So while the motor runs, head position is a pure function of cpu->cycles - nothing
+ * advances on its own, and a spinning drive nobody is reading costs nothing.
+ *
+ * The latch: a completed nybble (hi bit set) is visible for the first DISKII_LATCH_HOLD_CYCLES
+ * of its window, then the next nybble starts shifting in, 4 cycles per bit, hi bit clear
+ * until it completes. A LDA $C08C,X / BPL poll loop is 7 cycles, so it can't miss one.
+ */
+#define DISKII_CYCLES_PER_NYBBLE 32
+#define DISKII_CYCLES_PER_BIT 4
+#define DISKII_LATCH_HOLD_CYCLES 8
 
-    if (!disk.motor) { // return the same data every time if motor is off.
-        return disk.read_shift_register;
-    }
+inline uint16_t nybble_under_head(diskII& disk, uint64_t cycles) {
+    return ((cycles - disk.spin_base_cycle) / DISKII_CYCLES_PER_NYBBLE) % TRACK_MAX_SIZE;
+}
 
-#if 0
-    // thought this would be acclerated, but, is slower. Just return the next byte.
-    disk.read_shift_register = disk.nibblized.tracks[disk.track/2].data[disk.head_position];
-    if (disk.head_position++ >= 0x1A00) { // rotated around back to start.
-        disk.head_position = 0;
-    }
-    return disk.read_shift_register;
-#else
-    // Accurate version. Require the caller to shift each bit out one by one.
-    if (disk.bit_position == 0) {
-        // get next value from head_position to read_shift_register, increment head position.
-        disk.read_shift_register = disk.nibblized.tracks[disk.track/2].data[disk.head_position];
-        // "spin" the virtual diskette a little more
-        disk.head_position++;
-        if (disk.head_position >= 0x1A00) { // rotated around back to start.
-            disk.head_position = 0;
-        }
-    }
+void diskii_motor_start(cpu_state *cpu, diskII& disk) {
+    // pick up rotation where it stopped.
+    disk.spin_base_cycle = cpu->cycles - ((uint64_t)disk.head_position * DISKII_CYCLES_PER_NYBBLE);
+    disk.motor = 1;
+}
 
-    disk.bit_position++;
-    uint8_t shiftedbyte = (disk.read_shift_register >> (8 - disk.bit_position) );
-    if (disk.bit_position == 8) { // end of byte? Trigger move to next byte.
-        disk.bit_position = 0;
-    };
-    //printf("read_nybble from track%d head position %d read_shift_register %02X ", disk->track, disk->head_position, disk->read_shift_register);
-    //printf("shifted byte %02X\n", shiftedbyte);
-    return shiftedbyte;
-#endif
+void diskii_motor_stop(diskII& disk, uint64_t cycles) {
+    disk.head_position = nybble_under_head(disk, cycles);
+    disk.motor = 0;
 }
 
-void mount_diskII(cpu_state *cpu, uint8_t slot, uint8_t drive, media_descriptor *media) {
-    diskII_controller * diskII_slot = (diskII_controller *)get_module_state(cpu, MODULE_DISKII);
+/**
+ * motor off is delayed by a second. We apply it lazily whenever someone looks at the drive,
+ * and freeze the head where it was at the actual stop time, not at the time we noticed.
+ */
+void diskii_check_motor_off(cpu_state *cpu, diskII& disk) {
+    if (disk.motor == 1 && disk.mark_cycles_turnoff != 0 && ((cpu->cycles > disk.mark_cycles_turnoff))) {
+        if (DEBUG(DEBUG_DISKII)) printf("motor off: %llu %llu cycles\n", cpu->cycles, disk.mark_cycles_turnoff);
+        diskii_motor_stop(disk, disk.mark_cycles_turnoff);
+        disk.mark_cycles_turnoff = 0;
+    }
+}
 
-    if (diskII_slot[slot].drive[drive].is_mounted) {
-        fprintf(stderr, "A disk already mounted, unmounting it.\n");
-        unmount_diskII(cpu, slot, drive);
+uint8_t read_nybble(cpu_state *cpu, diskII& disk) {
+
+    if (!disk.motor) { // return the same data every time if motor is off.
+        return disk.read_shift_register;
     }
 
+    uint64_t elapsed = cpu->cycles - disk.spin_base_cycle;
+    uint16_t position = (elapsed / DISKII_CYCLES_PER_NYBBLE) % TRACK_MAX_SIZE;
+    uint32_t offset = elapsed % DISKII_CYCLES_PER_NYBBLE;
+    uint8_t *data = disk.nibblized->tracks[disk.track/2].data;
+
+    uint8_t value;
+    if (offset < DISKII_LATCH_HOLD_CYCLES) {
+        value = data[position];
+    } else {
+        uint16_t next = (position + 1) % TRACK_MAX_SIZE;
+        uint32_t bits = ((offset - DISKII_LATCH_HOLD_CYCLES) / DISKII_CYCLES_PER_BIT) + 1;
+        value = data[next] >> (8 - bits);
+    }
+    disk.head_position = position;
+    disk.read_shift_register = value;
+    //printf("read_nybble from track%d head position %d value %02X\n", disk.track, position, value);
+    return value;
+}
+
+/**
+ * The slow part of a mount: read the image and nibblize it into a new
+ * nibblized_disk_t hung off the media descriptor. Touches no drive state, so
+ * Mounts does this on its worker thread, and mount_diskII only has to swap
+ * the pointer in.
+ */
+int diskii_prepare_media(media_descriptor *media) {
     if (media->data_size != 140 * 1024) {
         fprintf(stderr, "Disk image is not 140K\n");
-        return;
+        return -1;
     }
 
+    nibblized_disk_t *nibblized = new nibblized_disk_t();
+
     // Detect DOS 3.3 or ProDOS and set the interleave accordingly done by identify_media
     // if filename ends in .po, use po_phys_to_logical and po_logical_to_phys.
     // if filename ends in .do, use do_phys_to_logical and do_logical_to_phys.
     // if filename ends in .dsk, use do_phys_to_logical and do_logical_to_phys.
     if (media->media_type == MEDIA_PRENYBBLE) {
         // Load nib format image directly into diskII structure.
-        load_nib_image(diskII_slot[slot].drive[drive].nibblized, media->filename);
-        printf("Mounted pre-nibblized disk %s\n", media->filestub);
+        load_nib_image(*nibblized, media->filename);
     } else {
         if (media->interleave == INTERLEAVE_PO) {
-            memcpy(diskII_slot[slot].drive[drive].nibblized.interleave_phys_to_logical, po_phys_to_logical, sizeof(interleave_t));
-            memcpy(diskII_slot[slot].drive[drive].nibblized.interleave_logical_to_phys, po_logical_to_phys, sizeof(interleave_t));
+            memcpy(nibblized->interleave_phys_to_logical, po_phys_to_logical, sizeof(interleave_t));
+            memcpy(nibblized->interleave_logical_to_phys, po_logical_to_phys, sizeof(interleave_t));
         } else if (media->interleave == INTERLEAVE_DO) {
-            memcpy(diskII_slot[slot].drive[drive].nibblized.interleave_phys_to_logical, do_phys_to_logical, sizeof(interleave_t));
-            memcpy(diskII_slot[slot].drive[drive].nibblized.interleave_logical_to_phys, do_logical_to_phys, sizeof(interleave_t));
+            memcpy(nibblized->interleave_phys_to_logical, do_phys_to_logical, sizeof(interleave_t));
+            memcpy(nibblized->interleave_logical_to_phys, do_logical_to_phys, sizeof(interleave_t));
         }
 
-        load_disk_image(diskII_slot[slot].drive[drive].media, media->filename); // pull this into diskii stuff somewhere.
-        emit_disk(diskII_slot[slot].drive[drive].nibblized, diskII_slot[slot].drive[drive].media, 0xFE);
-        printf("Mounted disk %s\n", media->filestub);
+        disk_image_t *image = new disk_image_t();
+        load_disk_image(*image, media->filename);
+        emit_disk(*nibblized, *image, 0xFE);
+        delete image;
+    }
+    media->nibblized = nibblized;
+    return 0;
+}
+
+int mount_diskII(cpu_state *cpu, uint8_t slot, uint8_t drive, media_descriptor *media) {
+    diskII_controller * diskII_slot = (diskII_controller *)get_module_state(cpu, MODULE_DISKII);
+
+    // not prepared ahead of time - do it here.
+    if (media->nibblized == nullptr && diskii_prepare_media(media) != 0) {
+        return -1;
     }
+
+    if (diskII_slot[slot].drive[drive].is_mounted) {
+        fprintf(stderr, "A disk already mounted, unmounting it.\n");
+        unmount_diskII(cpu, slot, drive);
+    }
+
+    diskII_slot[slot].drive[drive].nibblized = media->nibblized;
     diskII_slot[slot].drive[drive].is_mounted = true;
     diskII_slot[slot].drive[drive].media_d = media;
+    printf("Mounted disk %s\n", media->filestub);
+    cpu->mounts->publish((slot << 8) | drive, DRIVE_EVENT_MOUNT, 0, media->filestub);
+    return 0;
 }
 
 void unmount_diskII(cpu_state *cpu, uint8_t slot, uint8_t drive) {
     diskII_controller * diskII_slot = (diskII_controller *)get_module_state(cpu, MODULE_DISKII);
+    diskII &seldrive = diskII_slot[slot].drive[drive];
 
-    // reset all the track parameters to default to prepare for loading a new image.
-    for (int i = 0; i < 35; i++) {
-        diskII_slot[slot].drive[drive].nibblized.tracks[i].size = 0;
-        diskII_slot[slot].drive[drive].nibblized.tracks[i].position = 0;
+    if (seldrive.nibblized != &diskii_no_disk) {
+        delete seldrive.nibblized;
     }
-    diskII_slot[slot].drive[drive].is_mounted = false;
-    diskII_slot[slot].drive[drive].media_d = nullptr;
+    if (seldrive.media_d) {
+        seldrive.media_d->nibblized = nullptr;
+    }
+    seldrive.nibblized = &diskii_no_disk;
+    seldrive.is_mounted = false;
+    seldrive.media_d = nullptr;
+    cpu->mounts->publish((slot << 8) | drive, DRIVE_EVENT_UNMOUNT);
     // TODO: this will write the disk image back to disk.
 }
 
@@ -318,11 +376,7 @@ drive_status_t diskii_status(cpu_state *cpu, uint64_t key) {
     uint8_t drive = key & 0xFF;
     diskII &seldrive = diskII_slot[slot].drive[drive];
 
-    if (seldrive.motor == 1 && seldrive.mark_cycles_turnoff != 0 && ((cpu->cycles > seldrive.mark_cycles_turnoff))) {
-        if (DEBUG(DEBUG_DISKII)) printf("motor off: %llu %llu cycles\n", cpu->cycles, seldrive.mark_cycles_turnoff);
-        seldrive.motor = 0;
-        seldrive.mark_cycles_turnoff = 0;
-    }
+    diskii_check_motor_off(cpu, seldrive);
     const char *fname = nullptr;
     if (seldrive.media_d) {
         fname = seldrive.media_d->filestub;
@@ -361,11 +415,7 @@ uint8_t diskII_read_C0xx(cpu_state *cpu, uint16_t address) {
 
     diskII &seldrive = diskII_slot[slot].drive[drive];
 
-    if (seldrive.motor == 1 && seldrive.mark_cycles_turnoff != 0 && ((cpu->cycles > seldrive.mark_cycles_turnoff))) {
-        if (DEBUG(DEBUG_DISKII)) printf("motor off: %llu %llu cycles\n", cpu->cycles, seldrive.mark_cycles_turnoff);
-        seldrive.motor = 0;
-        seldrive.mark_cycles_turnoff = 0;
-    }
+    diskii_check_motor_off(cpu, seldrive);
 
     int8_t last_phase_on = seldrive.last_phase_on;
     int8_t cur_track = seldrive.track;
@@ -432,18 +482,25 @@ uint8_t diskII_read_C0xx(cpu_state *cpu, uint16_t address) {
         case DiskII_Motor_Off:          // turns off BOTH drives
             if (DEBUG(DEBUG_DISKII)) DEBUG_MOT(slot, drive, seldrive.motor);
             // if motor already off, do nothing.
-            if (diskII_slot[slot].drive[0].motor == 1) {
+            if (diskII_slot[slot].drive[0].motor == 1 && diskII_slot[slot].drive[0].mark_cycles_turnoff == 0) {
                 diskII_slot[slot].drive[0].mark_cycles_turnoff = cpu->cycles + 1000000;
+                cpu->mounts->publish_at((slot << 8) | 0, DRIVE_EVENT_MOTOR_OFF, diskII_slot[slot].drive[0].mark_cycles_turnoff);
                 if (DEBUG(DEBUG_DISKII)) printf("schedule motor off at %llu (is now %llu)\n", diskII_slot[slot].drive[0].mark_cycles_turnoff, cpu->cycles);
             }
-            if (diskII_slot[slot].drive[1].motor == 1) {
+            if (diskII_slot[slot].drive[1].motor == 1 && diskII_slot[slot].drive[1].mark_cycles_turnoff == 0) {
                 diskII_slot[slot].drive[1].mark_cycles_turnoff = cpu->cycles + 1000000;
+                cpu->mounts->publish_at((slot << 8) | 1, DRIVE_EVENT_MOTOR_OFF, diskII_slot[slot].drive[1].mark_cycles_turnoff);
                 if (DEBUG(DEBUG_DISKII)) printf("schedule motor off at %llu (is now %llu)\n", diskII_slot[slot].drive[1].mark_cycles_turnoff, cpu->cycles);
             }
             break;
         case DiskII_Motor_On:
             if (DEBUG(DEBUG_DISKII)) DEBUG_MOT(slot, drive, seldrive.motor);
-            seldrive.motor = 1;
+            if (seldrive.motor == 0 || seldrive.mark_cycles_turnoff != 0) {
+                cpu->mounts->publish((slot << 8) | drive, DRIVE_EVENT_MOTOR_ON);
+            }
+            if (seldrive.motor == 0) {
+                diskii_motor_start(cpu, seldrive);
+            }
             seldrive.mark_cycles_turnoff = 0; // if we turn motor on, reset this and don't stop it!
             break;
         case DiskII_Drive1_Select:
@@ -479,13 +536,7 @@ uint8_t diskII_read_C0xx(cpu_state *cpu, uint16_t address) {
 
     /* ANY even address read will get the contents of the current nibble. */
     if (((reg & 0x01) == 0) && (seldrive.Q7 == 0 && seldrive.Q6 == 0)) {
-        // if more than X cycles have elapsed since last read, set bit_position to 0 and move head X bytes forward.
-        /* if (cpu->cycles - seldrive.last_read_cycle > 60) {
-            seldrive.bit_position = 0;
-            seldrive.head_position = (seldrive.head_position +  ((cpu->cycles - seldrive.last_read_cycle) / 32) ) % 0x1A00;
-        }
-        seldrive.last_read_cycle = cpu->cycles; */
-        return read_nybble(seldrive);
+        return read_nybble(cpu, seldrive);
     }
 
     if (seldrive.track != cur_track) {
@@ -496,6 +547,9 @@ uint8_t diskII_read_C0xx(cpu_state *cpu, uint16_t address) {
         if (DEBUG(DEBUG_DISKII)) fprintf(stdout, "track < 0, CHUGGA CHUGGA CHUGGA\n");
         seldrive.track = 0;
     }
+    if (seldrive.track != cur_track) {
+        cpu->mounts->publish((slot << 8) | drive, DRIVE_EVENT_TRACK, seldrive.track);
+    }
     return 0xEE;
 }
 
@@ -504,34 +558,36 @@ void diskII_write_C0xx(cpu_state *cpu, uint16_t address, uint8_t value) {
 }
 
 
-void diskII_init(cpu_state *cpu) {
-    // clear out and reset all potential slots etc to sane states.
+/* put one controller and its drives in a sane state. other slots are left alone. */
+void diskII_init(cpu_state *cpu, SlotType_t slot) {
     diskII_controller * diskII_slot = (diskII_controller *)get_module_state(cpu, MODULE_DISKII);
 
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 2; j++) {
-            diskII_slot[i].drive[j].track = 0;
-            diskII_slot[i].drive[j].phase0 = 0;
-            diskII_slot[i].drive[j].phase1 = 0;
-            diskII_slot[i].drive[j].phase2 = 0;
-            diskII_slot[i].drive[j].phase3 = 0;
-            diskII_slot[i].drive[j].motor = 0;
-            diskII_slot[i].drive[j].last_phase_on = 0;
-            diskII_slot[i].drive[j].image_index = 0;
-            diskII_slot[i].drive[j].write_protect = 1;
-            diskII_slot[i].drive[j].bit_position = 0; // how many bits left in byte.
-            diskII_slot[i].drive[j].read_shift_register = 0; // when bit position = 0, this is 0. As bit_position increments, we shift in the next bit of the byte at head_position.
-            diskII_slot[i].drive[j].head_position = 0; // index into the track
-            diskII_slot[i].drive[j].mark_cycles_turnoff = 0; // when DRIVES OFF, set this to current cpu cycles. Then don't actually set motor=0 until one second (1M cycles) has passed. Then reset this to 0.
-        }
-        diskII_slot[i].drive_select = 0;
+    for (int j = 0; j < 2; j++) {
+        diskII_slot[slot].drive[j].track = 0;
+        diskII_slot[slot].drive[j].phase0 = 0;
+        diskII_slot[slot].drive[j].phase1 = 0;
+        diskII_slot[slot].drive[j].phase2 = 0;
+        diskII_slot[slot].drive[j].phase3 = 0;
+        diskII_slot[slot].drive[j].motor = 0;
+        diskII_slot[slot].drive[j].last_phase_on = 0;
+        diskII_slot[slot].drive[j].image_index = 0;
+        diskII_slot[slot].drive[j].write_protect = 1;
+        diskII_slot[slot].drive[j].read_shift_register = 0;
+        diskII_slot[slot].drive[j].head_position = 0; // index into the track
+        diskII_slot[slot].drive[j].spin_base_cycle = 0;
+        diskII_slot[slot].drive[j].mark_cycles_turnoff = 0; // when DRIVES OFF, set this to current cpu cycles. Then don't actually set motor=0 until one second (1M cycles) has passed. Then reset this to 0.
     }
+    diskII_slot[slot].drive_select = 0;
+    diskII_slot[slot].installed = true;
 }
 
 void init_slot_diskII(cpu_state *cpu, SlotType_t slot) {
-    diskII_controller * diskII_slot = new diskII_controller[8];
-    // set in CPU so we can reference later
-    set_module_state(cpu, MODULE_DISKII, diskII_slot);
+    // one state block for every Disk II card in the machine; the first card to power on makes it.
+    diskII_controller * diskII_slot = (diskII_controller *)get_module_state(cpu, MODULE_DISKII);
+    if (diskII_slot == nullptr) {
+        diskII_slot = new diskII_controller[8]();
+        set_module_state(cpu, MODULE_DISKII, diskII_slot);
+    }
 
     fprintf(stdout, "diskII_register_slot %d\n", slot);
 
@@ -545,8 +601,7 @@ void init_slot_diskII(cpu_state *cpu, SlotType_t slot) {
     // memory-map the page. Refactor to have a method to get and set memory map.
     uint8_t *rom_data = (uint8_t *)(rom->get_data());
 
-    // clear out and reset all potential slots etc to sane states.
-    diskII_init(cpu);
+    diskII_init(cpu, slot);
 
     uint16_t slot_base = 0xC080 + (slot * 0x10);
 
@@ -579,18 +634,22 @@ void init_slot_diskII(cpu_state *cpu, SlotType_t slot) {
 
     // register drives with mounts for status reporting
     uint64_t key = (slot << 8) | 0;
-    cpu->mounts->register_drive(DRIVE_TYPE_DISKII, key);
-    cpu->mounts->register_drive(DRIVE_TYPE_DISKII, key + 1);
+    cpu->mounts->register_drive(key);
+    cpu->mounts->register_drive(key + 1);
 
+    register_reset_handler(cpu, diskii_reset);
 }
 
 void diskii_reset(cpu_state *cpu) {
     diskII_controller * diskII_slot = (diskII_controller *)get_module_state(cpu, MODULE_DISKII);
     printf("diskii_reset\n");
-    // TODO: this should be a callback from the CPU reset handler.
     for (int i = 0; i < 8; i++) {
+        if (!diskII_slot[i].installed) continue;
         for (int j = 0; j < 2; j++) {
-            diskII_slot[i].drive[j].motor = 0;
+            if (diskII_slot[i].drive[j].motor) {
+                diskii_motor_stop(diskII_slot[i].drive[j], cpu->cycles);
+                cpu->mounts->publish_at((i << 8) | j, DRIVE_EVENT_MOTOR_OFF, cpu->cycles);
+            }
             diskII_slot[i].drive[j].mark_cycles_turnoff = 0;
         }
     }
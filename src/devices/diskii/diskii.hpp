@@ -38,7 +38,8 @@
 #define DiskII_Q7H 0x0F
 
 void init_slot_diskII(cpu_state *cpu, SlotType_t slot);
-void mount_diskII(cpu_state *cpu, uint8_t slot, uint8_t drive, media_descriptor *media);
+int diskii_prepare_media(media_descriptor *media);
+int mount_diskII(cpu_state *cpu, uint8_t slot, uint8_t drive, media_descriptor *media);
 void unmount_diskII(cpu_state *cpu, uint8_t slot, uint8_t drive);
 drive_status_t diskii_status(cpu_state *cpu, uint64_t key);
 void diskii_reset(cpu_state *cpu);
@@ -17,6 +17,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "diskii_fmt.hpp"
 #include "debug.hpp"
@@ -57,6 +58,29 @@ uint8_t translate_62[64] = {
     0xED, 0xEE, 0xEF, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF    
 };
 
+/**
+ * And back again: disk nibble -> 6-bit value. 0xFF marks bytes that can't
+ * appear in 6-and-2 data (high bit clear, reserved D5/AA, too many zeros).
+ */
+uint8_t detranslate_62[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x01, 0xFF, 0xFF, 0x02, 0x03, 0xFF, 0x04, 0x05, 0x06,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0x08, 0xFF, 0xFF, 0xFF, 0x09, 0x0A, 0x0B, 0x0C, 0x0D,
+    0xFF, 0xFF, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0xFF, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x1B, 0xFF, 0x1C, 0x1D, 0x1E,
+    0xFF, 0xFF, 0xFF, 0x1F, 0xFF, 0xFF, 0x20, 0x21, 0xFF, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x29, 0x2A, 0x2B, 0xFF, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32,
+    0xFF, 0xFF, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0xFF, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+};
+
 /**
  * **********************************************************************************************
  * Utility functions for debugging.
@@ -508,7 +532,176 @@ void write_disk(nibblized_disk_t& disk, const char *filename) {
 }
 
 /**
- * when handling writes, we will need to decode the nibbles back to bytes.
- * particularly, the address field, so then we know which disk_image track and sector
- * to write the data back to.
- */
\ No newline at end of file
+ * **********************************************************************************************
+ * Denibblizing - the way back, for writing a modified .nib out as .dsk/.po.
+ * Tracks are decoded a whole sector at a time with table lookups, not by
+ * stepping a simulated read head through them.
+ */
+
+/**
+ * Inverse of prenibble. nbuf[0..FF] holds the high 6 bits of each byte;
+ * nbuf[100..155] holds the low 2 bits, three bytes' worth per entry.
+ * Following prenibble's loop: byte y's bits went into entry x = (257 - y) % 0x56,
+ * on pass (257 - y) / 0x56, and each pass shifts the previous ones up by two. The
+ * pair also goes in bit-reversed (bit 0 is ROLed in first).
+ */
+void postnibble(sector_62_t& nbuf, sector_t& buf) {
+    static const uint8_t swap2[4] = { 0, 2, 1, 3 };
+    uint8_t *nbuf1 = nbuf;
+    uint8_t *nbuf2 = nbuf + 0x100;
+
+    // walk n = 257 - y upward, so x and the pass just count instead of dividing.
+    int x = 2, shift = 4;
+    for (int y = 0xFF; y >= 0; y--) {
+        uint8_t low2 = (nbuf2[x] >> shift) & 0b11;
+        buf[y] = (nbuf1[y] << 2) | swap2[low2];
+        if (++x == 0x56) {
+            x = 0;
+            shift -= 2;
+        }
+    }
+}
+
+static inline uint8_t decode_44(const uint8_t *p) {
+    return ((p[0] << 1) | 0x01) & p[1];
+}
+
+/**
+ * Decode the 343 disk nibbles of a data field (after D5 AA AD) into a sector.
+ * Each nibble is detranslate_62[] XOR the previous decoded value; the 343rd
+ * is the checksum, which must equal the last value. Returns false on a bad
+ * nibble or checksum.
+ */
+bool denibblize_sector(const uint8_t *in, sector_t& out) {
+    sector_62_t nbuf;
+    uint8_t last = 0;
+    uint8_t bad = 0;
+
+    for (int i = 0x0155; i >= 0x0100; i--) {
+        uint8_t v = detranslate_62[*in++];
+        bad |= v;
+        last ^= v;
+        nbuf[i] = last;
+    }
+    for (int i = 0x00; i <= 0xFF; i++) {
+        uint8_t v = detranslate_62[*in++];
+        bad |= v;
+        last ^= v;
+        nbuf[i] = last;
+    }
+    uint8_t checksum = detranslate_62[*in];
+    bad |= checksum;
+
+    if ((bad & 0x80) || checksum != last) {  // every good value is < 0x40, so one OR catches any 0xFF.
+        return false;
+    }
+    postnibble(nbuf, out);
+    return true;
+}
+
+/**
+ * Find the next D5 AA <p3> prologue at or after pos, using memchr to skip the
+ * sync bytes between fields. Returns the offset of the D5, or -1.
+ */
+static int find_prologue(const uint8_t *data, int pos, int end, uint8_t p3) {
+    while (pos < end - 2) {
+        const uint8_t *d5 = (const uint8_t *)memchr(data + pos, 0xD5, end - 2 - pos);
+        if (d5 == nullptr) {
+            return -1;
+        }
+        pos = d5 - data;
+        if (data[pos + 1] == 0xAA && data[pos + 2] == p3) {
+            return pos;
+        }
+        pos++;
+    }
+    return -1;
+}
+
+/**
+ * Decode every sector on one nibblized track. sectors[] is indexed by the
+ * physical sector number from each address field. Returns a bitmask of the
+ * physical sectors found with good checksums.
+ *
+ * The track is circular, so a field can start near the end and finish at the
+ * beginning; we scan a copy with the first few hundred bytes appended to cover that.
+ */
+uint16_t denibblize_track(const uint8_t *track_data, int track_size, sector_t sectors[SECTORS_PER_TRACK]) {
+    const int WRAP = ADDRESS_FIELD_SIZE + GAP_B_SIZE * 4 + DATA_FIELD_SIZE;
+    uint8_t ring[TRACK_MAX_SIZE + WRAP];
+
+    if (track_size <= 0 || track_size > TRACK_MAX_SIZE) {
+        track_size = TRACK_MAX_SIZE;
+    }
+    memcpy(ring, track_data, track_size);
+    memcpy(ring + track_size, track_data, WRAP < track_size ? WRAP : track_size);
+    int end = track_size + WRAP;
+
+    uint16_t found = 0;
+    int pos = 0;
+    while (pos < track_size) {
+        // + 2 so a prologue starting in the last two bytes, and finishing in the
+        // wrapped copy, is still found.
+        int addr = find_prologue(ring, pos, track_size + 2, 0x96);
+        if (addr < 0) {
+            break;
+        }
+        pos = addr + 3;
+        if (pos + 8 > end) {
+            break;
+        }
+        uint8_t volume = decode_44(ring + pos);
+        uint8_t track = decode_44(ring + pos + 2);
+        uint8_t sector = decode_44(ring + pos + 4);
+        uint8_t checksum = decode_44(ring + pos + 6);
+        if ((volume ^ track ^ sector) != checksum || sector >= SECTORS_PER_TRACK) {
+            continue;
+        }
+        pos += 8;
+
+        // the data field should follow within a gap; don't wander into the next sector's.
+        int data = find_prologue(ring, pos, pos + GAP_B_SIZE * 4 + 3 < end ? pos + GAP_B_SIZE * 4 + 3 : end, 0xAD);
+        if (data < 0 || data + 3 + 343 > end) {
+            continue;
+        }
+        if (denibblize_sector(ring + data + 3, sectors[sector])) {
+            found |= 1 << sector;
+        }
+        pos = data + 3 + 343;
+    }
+    return found;
+}
+
+/**
+ * Decode a whole nibblized disk back into logical sector order, using the
+ * disk's interleave. Returns the number of sectors that were missing or bad
+ * (their contents in disk_image are left alone).
+ */
+int denibblize_disk(nibblized_disk_t& disk, disk_image_t& disk_image) {
+    int missing = 0;
+    for (int t = 0; t < TRACKS_PER_DISK; t++) {
+        sector_t phys[SECTORS_PER_TRACK];
+        uint16_t found = denibblize_track(disk.tracks[t].data, disk.tracks[t].size, phys);
+        for (int s = 0; s < SECTORS_PER_TRACK; s++) {
+            if (found & (1 << s)) {
+                memcpy(disk_image.sectors[t][disk.interleave_phys_to_logical[s]], phys[s], SECTOR_SIZE);
+            } else {
+                missing++;
+            }
+        }
+    }
+    return missing;
+}
+
+int write_disk_image(disk_image_t& disk_image, const char *filename) {
+    FILE *out_fp = fopen(filename, "wb");
+    if (!out_fp) {
+        printf("Could not open %s for writing\n", filename);
+        return -1;
+    }
+
+    fwrite(disk_image.sectors, SECTOR_SIZE, TRACKS_PER_DISK * SECTORS_PER_TRACK, out_fp);
+
+    fclose(out_fp);
+    return 0;
+}
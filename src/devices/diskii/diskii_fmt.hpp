@@ -25,7 +25,8 @@
  * Converts a raw disk image, which is just a series of sectors in logical
  * order, into a nibblized disk image, which is a series of encoded tracks.
  * 
- * Currently this is read-only.
+ * And back: denibblize_disk turns a (possibly modified) nibblized disk back
+ * into a raw image.
  */
 
 /**
@@ -41,6 +42,7 @@
 // AA, D5 - Reserved Bytes, not included in the 6-and-2 encoding.
 
 extern uint8_t translate_62[64];
+extern uint8_t detranslate_62[256];
 
 
 /**
@@ -116,7 +118,14 @@ extern interleave_t cpm_order;
 
 void dump_disk_image(disk_image_t& disk_image);
 int load_disk_image(disk_image_t& disk_image, const char *filename);
+void prenibble(sector_t& buf, sector_62_t& nbuf);
+void emit_track(nibblized_disk_t& disk, disk_image_t& disk_image, int volume, int track);
 void emit_disk(nibblized_disk_t& disk, disk_image_t& disk_image, int volume);
 void write_disk(nibblized_disk_t& disk, const char *filename);
 void dump_disk(nibblized_disk_t& disk);
 int load_nib_image(nibblized_disk_t& disk, const char *filename);
+void postnibble(sector_62_t& nbuf, sector_t& buf);
+bool denibblize_sector(const uint8_t *in, sector_t& out);
+uint16_t denibblize_track(const uint8_t *track_data, int track_size, sector_t sectors[SECTORS_PER_TRACK]);
+int denibblize_disk(nibblized_disk_t& disk, disk_image_t& disk_image);
+int write_disk_image(disk_image_t& disk_image, const char *filename);
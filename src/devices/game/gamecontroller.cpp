@@ -58,8 +58,22 @@ int game_input_trigger_3 = 0; */
 
 #define GAME_INPUT_DECAY_TIME 2800
 
+/**
+ * Nothing needs a joystick until the program actually reads the paddles or
+ * buttons, so don't start the subsystem (and its device scan) until then.
+ * Sticks already plugged in show up as JOYSTICK_ADDED events right after.
+ */
+static inline void game_input_first_use(gamec_state_t *ds) {
+    if (ds->joystick_init_done) return;
+    ds->joystick_init_done = true;
+    if (!gs2_app_values.no_joystick) {
+        SDL_InitSubSystem(SDL_INIT_JOYSTICK);
+    }
+}
+
 uint8_t strobe_game_inputs(cpu_state *cpu, uint16_t address) {
     gamec_state_t *ds = (gamec_state_t *)get_module_state(cpu, MODULE_GAMECONTROLLER);
+    game_input_first_use(ds);
 
     float mouse_x, mouse_y;
     SDL_GetMouseState(&mouse_x, &mouse_y);
@@ -133,6 +147,7 @@ uint8_t read_game_input_3(cpu_state *cpu, uint16_t address) {
 
 uint8_t read_game_switch_0(cpu_state *cpu, uint16_t address) {
     gamec_state_t *ds = (gamec_state_t *)get_module_state(cpu, MODULE_GAMECONTROLLER);
+    game_input_first_use(ds);
     if (ds->gtype[0] == GAME_INPUT_TYPE_JOYSTICK) {
         if (SDL_GetJoystickButton(ds->joystick0, 2) != 0) {
             ds->game_switch_0 = 1;
@@ -149,6 +164,7 @@ uint8_t read_game_switch_0(cpu_state *cpu, uint16_t address) {
 
 uint8_t read_game_switch_1(cpu_state *cpu, uint16_t address) {
     gamec_state_t *ds = (gamec_state_t *)get_module_state(cpu, MODULE_GAMECONTROLLER);
+    game_input_first_use(ds);
     if (ds->gtype[0] == GAME_INPUT_TYPE_JOYSTICK) {
         if (SDL_GetJoystickButton(ds->joystick0, 3) != 0) {
             ds->game_switch_1 = 1;
@@ -206,7 +222,6 @@ void joystick_removed(cpu_state *cpu, SDL_Event *event) {
 }
 
 void init_mb_game_controller(cpu_state *cpu, SlotType_t slot) {
-    SDL_InitSubSystem(SDL_INIT_JOYSTICK);
     // alloc and init display state
     gamec_state_t *ds = new gamec_state_t;
     ds->game_switch_0 = 0;
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <SDL3/SDL.h>
+
 #include "gs2.hpp"
 #include "cpu.hpp"
 
@@ -66,6 +68,7 @@ typedef struct gamec_state_t {
     int mouse_wheel_pos_0; // only one wheel per mouse.
     int paddle_flip_01;
     SDL_Joystick *joystick0;
+    bool joystick_init_done; // SDL joystick subsystem is brought up on the first paddle/button read.
 } gamec_state_t;
 
 void init_mb_game_controller(cpu_state *cpu, SlotType_t slot);
@@ -0,0 +1,303 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gs2.hpp"
+#include "cpu.hpp"
+#include "bus.hpp"
+#include "memory.hpp"
+#include "memoryspecs.hpp"
+#include "debug.hpp"
+#include "display/display.hpp"
+#include "devices/languagecard/languagecard.hpp"
+#include "devices/iiememory/iiememory.hpp"
+#include "util/reset.hpp"
+
+/**
+ * Build the page tables for $0000-$BFFF for every combination of the six
+ * switches that affect it. Index is the IIE_SW_* bits, masked with
+ * IIE_PAGE_SET_MASK.
+ */
+static void iie_build_page_sets(cpu_state *cpu, iiememory_state_t *st) {
+    for (int set = 0; set < IIE_NUM_PAGE_SETS; set++) {
+        iie_page_set_t *ps = &st->page_sets[set];
+        uint8_t *zp = (set & IIE_SW_ALTZP) ? cpu->aux_ram_64 : cpu->main_ram_64;
+        uint8_t *rd = (set & IIE_SW_RAMRD) ? cpu->aux_ram_64 : cpu->main_ram_64;
+        uint8_t *wr = (set & IIE_SW_RAMWRT) ? cpu->aux_ram_64 : cpu->main_ram_64;
+        uint8_t *video = (set & IIE_SW_PAGE2) ? cpu->aux_ram_64 : cpu->main_ram_64;
+        bool store80 = (set & IIE_SW_80STORE) != 0;
+        bool hires = (set & IIE_SW_HIRES) != 0;
+
+        for (int page = 0; page < IIE_MAPPED_PAGES; page++) {
+            uint8_t *r, *w;
+            if (page < 0x02) {
+                r = w = zp;
+            } else if (store80 && ((page >= 0x04 && page <= 0x07) || (hires && page >= 0x20 && page <= 0x3F))) {
+                r = w = video;
+            } else {
+                r = rd;
+                w = wr;
+            }
+            ps->read[page] = r + page * GS2_PAGE_SIZE;
+            ps->write[page] = w + page * GS2_PAGE_SIZE;
+        }
+    }
+}
+
+static void iie_apply_page_set(cpu_state *cpu, iiememory_state_t *st) {
+    iie_page_set_t *ps = &st->page_sets[st->switches & IIE_PAGE_SET_MASK];
+    memcpy(cpu->memory->pages_read, ps->read, sizeof(ps->read));
+    memcpy(cpu->memory->pages_write, ps->write, sizeof(ps->write));
+}
+
+/* ALTZP also moves the language card RAM to aux. */
+static void iie_apply_altzp_langcard(cpu_state *cpu, iiememory_state_t *st) {
+    languagecard_state_t *lc = (languagecard_state_t *)get_module_state(cpu, MODULE_LANGCARD);
+    if (lc == nullptr) {
+        return;
+    }
+    lc->ram = (st->switches & IIE_SW_ALTZP) ? cpu->aux_ram_64 : cpu->main_ram_64;
+    set_memory_pages_based_on_flags(cpu);
+}
+
+static void iie_map_cx_page(cpu_state *cpu, uint8_t page, uint8_t *data, memory_type type) {
+    memory_map_page_both(cpu, page, data, type);
+    cpu->memory->page_info[page].can_write = (type == MEM_IO);
+}
+
+/**
+ * $C100-$CFFF. With INTCXROM on, the whole range is internal ROM. It's marked
+ * MEM_ROM so reads don't go through the bus, and touching $Cnxx doesn't hand
+ * $C800 to a slot. With it off, the slots are back, except $C3xx is internal
+ * unless SLOTC3ROM is on. The internal $C800 space comes in the usual way,
+ * as slot 3's $C800 page block.
+ */
+static void iie_apply_cx_rom(cpu_state *cpu, iiememory_state_t *st, bool was_intcxrom) {
+    if (cpu->main_rom_C0 == nullptr) {
+        return; // no IIe ROM loaded, leave the slots alone.
+    }
+
+    bool intcxrom = (st->switches & IIE_SW_INTCXROM) != 0;
+    bool internal_c3 = (st->switches & IIE_SW_SLOTC3ROM) == 0;
+
+    if (internal_c3) {
+        memcpy(cpu->C8xx_rom_pages[3], st->internal_C8_pages, sizeof(st->internal_C8_pages));
+        cpu->C8xx_handlers[3] = nullptr;
+    } else {
+        memcpy(cpu->C8xx_rom_pages[3], st->saved_C8xx_rom_pages_3, sizeof(st->saved_C8xx_rom_pages_3));
+        cpu->C8xx_handlers[3] = st->saved_C8xx_handler_3;
+    }
+
+    if (intcxrom) {
+        if (!was_intcxrom) {
+            for (int page = 0; page < 8; page++) {
+                st->saved_C8_read[page] = cpu->memory->pages_read[page + 0xC8];
+                st->saved_C8_write[page] = cpu->memory->pages_write[page + 0xC8];
+            }
+            // park the owner, so a $CFFF write (which still goes to the bus) has nothing to release over our ROM.
+            st->saved_C8xx_slot = cpu->C8xx_slot;
+            cpu->C8xx_slot = 0xFF;
+        }
+        for (int page = 0xC1; page <= 0xCF; page++) {
+            iie_map_cx_page(cpu, page, cpu->main_rom_C0 + (page - 0xC0) * GS2_PAGE_SIZE, MEM_ROM);
+        }
+        return;
+    }
+
+    for (int page = 0xC1; page <= 0xC7; page++) {
+        iie_map_cx_page(cpu, page, cpu->main_io_4 + (page - 0xC0) * GS2_PAGE_SIZE, MEM_IO);
+    }
+    if (internal_c3) {
+        iie_map_cx_page(cpu, 0xC3, cpu->main_rom_C0 + 0x03 * GS2_PAGE_SIZE, MEM_IO);
+    }
+    if (was_intcxrom) {
+        for (int page = 0; page < 8; page++) {
+            cpu->memory->pages_read[page + 0xC8] = st->saved_C8_read[page];
+            cpu->memory->pages_write[page + 0xC8] = st->saved_C8_write[page];
+            cpu->memory->page_info[page + 0xC8].type = MEM_IO;
+            cpu->memory->page_info[page + 0xC8].can_write = 1;
+        }
+        cpu->C8xx_slot = st->saved_C8xx_slot;
+    }
+}
+
+void iie_memory_write_C00x(cpu_state *cpu, uint16_t address, uint8_t value) {
+    iiememory_state_t *st = (iiememory_state_t *)get_module_state(cpu, MODULE_IIE_MEMORY);
+
+    uint8_t old_switches = st->switches;
+    static const uint8_t switch_bits[6] = {
+        IIE_SW_80STORE, IIE_SW_RAMRD, IIE_SW_RAMWRT, IIE_SW_INTCXROM, IIE_SW_ALTZP, IIE_SW_SLOTC3ROM
+    };
+    uint8_t bit = switch_bits[(address & 0x0F) >> 1];
+
+    if (address & 1) {
+        st->switches |= bit;
+    } else {
+        st->switches &= ~bit;
+    }
+    if (st->switches == old_switches) {
+        return;
+    }
+    if (DEBUG(DEBUG_IIE_MEMORY)) fprintf(stdout, "iie_memory_write_C00x %04X switches: %02X\n", address, st->switches);
+
+    if (bit & IIE_PAGE_SET_MASK) {
+        iie_apply_page_set(cpu, st);
+    }
+    if (bit == IIE_SW_ALTZP) {
+        iie_apply_altzp_langcard(cpu, st);
+    }
+    if (bit == IIE_SW_INTCXROM || bit == IIE_SW_SLOTC3ROM) {
+        iie_apply_cx_rom(cpu, st, (old_switches & IIE_SW_INTCXROM) != 0);
+    }
+    if (bit == IIE_SW_80STORE) {
+        // with 80STORE on, PAGE2 banks memory and the display stays on page 1.
+        bool page2 = (st->switches & (IIE_SW_80STORE | IIE_SW_PAGE2)) == IIE_SW_PAGE2;
+        set_display_page(cpu, page2 ? DISPLAY_PAGE_2 : DISPLAY_PAGE_1);
+        force_display_update(cpu);
+    }
+}
+
+uint8_t iie_memory_read_C01x(cpu_state *cpu, uint16_t address) {
+    iiememory_state_t *st = (iiememory_state_t *)get_module_state(cpu, MODULE_IIE_MEMORY);
+    uint8_t bit;
+
+    switch (address) {
+        case 0xC013: bit = IIE_SW_RAMRD; break;
+        case 0xC014: bit = IIE_SW_RAMWRT; break;
+        case 0xC015: bit = IIE_SW_INTCXROM; break;
+        case 0xC016: bit = IIE_SW_ALTZP; break;
+        case 0xC017: bit = IIE_SW_SLOTC3ROM; break;
+        case 0xC018: bit = IIE_SW_80STORE; break;
+        case 0xC01C: bit = IIE_SW_PAGE2; break;
+        case 0xC01D: bit = IIE_SW_HIRES; break;
+        default: return 0x00;
+    }
+    return (st->switches & bit) ? 0x80 : 0x00;
+}
+
+/**
+ * PAGE2 and HIRES ($C054-$C057). Track them for 80STORE, then pass through
+ * to the display - except PAGE2 with 80STORE on, which only banks memory.
+ */
+static bool iie_memory_track_C05x(cpu_state *cpu, uint16_t address) {
+    iiememory_state_t *st = (iiememory_state_t *)get_module_state(cpu, MODULE_IIE_MEMORY);
+    uint8_t bit = (address & 0x02) ? IIE_SW_HIRES : IIE_SW_PAGE2;
+    uint8_t old_switches = st->switches;
+
+    if (address & 1) {
+        st->switches |= bit;
+    } else {
+        st->switches &= ~bit;
+    }
+    if ((st->switches & IIE_SW_80STORE) && st->switches != old_switches) {
+        iie_apply_page_set(cpu, st);
+    }
+    return !(bit == IIE_SW_PAGE2 && (st->switches & IIE_SW_80STORE));
+}
+
+uint8_t iie_memory_read_C05x(cpu_state *cpu, uint16_t address) {
+    iiememory_state_t *st = (iiememory_state_t *)get_module_state(cpu, MODULE_IIE_MEMORY);
+    memory_read_handler display_handler = st->display_read_C05x[address - 0xC054];
+
+    if (iie_memory_track_C05x(cpu, address) && display_handler) {
+        return display_handler(cpu, address);
+    }
+    return 0;
+}
+
+void iie_memory_write_C05x(cpu_state *cpu, uint16_t address, uint8_t value) {
+    iiememory_state_t *st = (iiememory_state_t *)get_module_state(cpu, MODULE_IIE_MEMORY);
+    memory_write_handler display_handler = st->display_write_C05x[address - 0xC054];
+
+    if (iie_memory_track_C05x(cpu, address) && display_handler) {
+        display_handler(cpu, address, value);
+    }
+}
+
+static void iie_memory_apply_all(cpu_state *cpu, iiememory_state_t *st) {
+    iie_apply_page_set(cpu, st);
+    iie_apply_altzp_langcard(cpu, st);
+    iie_apply_cx_rom(cpu, st, false);
+}
+
+/**
+ * Goes after the display, language card and slot cards in the device map:
+ * we chain the display's $C054-$C057 handlers, and slot 3's $C800 ROM
+ * (if any) is what SLOTC3ROM switches back to.
+ */
+void init_mb_iie_memory(cpu_state *cpu, SlotType_t slot) {
+    iiememory_state_t *st = new iiememory_state_t();
+
+    cpu->aux_ram_64 = new uint8_t[RAM_KB]();
+    st->switches = 0;
+    st->saved_C8xx_handler_3 = cpu->C8xx_handlers[3];
+    memcpy(st->saved_C8xx_rom_pages_3, cpu->C8xx_rom_pages[3], sizeof(st->saved_C8xx_rom_pages_3));
+    for (int page = 0; page < 8; page++) {
+        st->internal_C8_pages[page] = cpu->main_rom_C0 ? cpu->main_rom_C0 + (page + 0x08) * GS2_PAGE_SIZE : nullptr;
+    }
+    iie_build_page_sets(cpu, st);
+
+    set_module_state(cpu, MODULE_IIE_MEMORY, st);
+
+    for (uint16_t address = 0xC000; address <= 0xC00B; address++) {
+        register_C0xx_memory_write_handler(address, iie_memory_write_C00x);
+    }
+    for (uint16_t address = 0xC013; address <= 0xC018; address++) {
+        register_C0xx_memory_read_handler(address, iie_memory_read_C01x);
+    }
+    register_C0xx_memory_read_handler(0xC01C, iie_memory_read_C01x);
+    register_C0xx_memory_read_handler(0xC01D, iie_memory_read_C01x);
+
+    for (uint16_t address = 0xC054; address <= 0xC057; address++) {
+        st->display_read_C05x[address - 0xC054] = get_C0xx_memory_read_handler(address);
+        st->display_write_C05x[address - 0xC054] = get_C0xx_memory_write_handler(address);
+        register_C0xx_memory_read_handler(address, iie_memory_read_C05x);
+        register_C0xx_memory_write_handler(address, iie_memory_write_C05x);
+    }
+
+    init_display_80col(cpu);
+
+    iie_memory_apply_all(cpu, st);
+    register_reset_handler(cpu, reset_iie_memory);
+}
+
+/**
+ * RESET turns all the MMU switches off. system_reset has already put the
+ * default map back ($C800 idle, no saved pages to restore), so this is the
+ * same as applying the switches from scratch.
+ * Unlike the II+ card, the IIe MMU also resets the bank-switched memory to
+ * read ROM, write RAM, bank 2 - otherwise the reset vector could come out of
+ * LC RAM. The LC's own reset handler ran before us and mapped the old flags;
+ * apply_all maps the new ones.
+ */
+void reset_iie_memory(cpu_state *cpu) {
+    iiememory_state_t *st = (iiememory_state_t *)get_module_state(cpu, MODULE_IIE_MEMORY);
+    if (st == nullptr) {
+        return;
+    }
+    languagecard_state_t *lc = (languagecard_state_t *)get_module_state(cpu, MODULE_LANGCARD);
+    if (lc != nullptr) {
+        lc->FF_BANK_1 = 0;
+        lc->FF_PRE_WRITE = 0;
+        lc->FF_READ_ENABLE = 0;
+        lc->_FF_WRITE_ENABLE = 0;
+    }
+    st->switches &= (IIE_SW_PAGE2 | IIE_SW_HIRES);
+    iie_memory_apply_all(cpu, st);
+}
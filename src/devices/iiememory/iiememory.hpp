@@ -0,0 +1,83 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/**
+ * Apple IIe auxiliary memory and the MMU soft switches.
+ *
+ * Write-only switches (any write; the value is ignored):
+ * C000 / C001 - 80STORE off / on. With it on, PAGE2 picks main / aux for
+ *               $0400-$07FF (and $2000-$3FFF if HIRES is on too) instead
+ *               of picking the displayed page.
+ * C002 / C003 - RAMRD off / on.     $0200-$BFFF reads from main / aux
+ * C004 / C005 - RAMWRT off / on.    $0200-$BFFF writes to main / aux
+ * C006 / C007 - INTCXROM off / on.  $C100-$CFFF is slot ROM / internal ROM
+ * C008 / C009 - ALTZP off / on.     $0000-$01FF and the language card RAM in main / aux
+ * C00A / C00B - SLOTC3ROM off / on. $C300 is internal ROM / slot 3
+ *
+ * Status reads (bit 7): C013 RAMRD, C014 RAMWRT, C015 INTCXROM, C016 ALTZP,
+ * C017 SLOTC3ROM, C018 80STORE, C01C PAGE2, C01D HIRES.
+ *
+ * Nothing here is checked per memory access. Every combination of the
+ * switches that affect $0000-$BFFF (ALTZP, RAMRD, RAMWRT, 80STORE, PAGE2,
+ * HIRES - 64 of them) has its page table built once at power-on; a switch
+ * just copies the matching set over the live page table.
+ */
+
+#include "gs2.hpp"
+#include "cpu.hpp"
+#include "bus.hpp"
+
+#define IIE_SW_ALTZP        0x01
+#define IIE_SW_RAMRD        0x02
+#define IIE_SW_RAMWRT       0x04
+#define IIE_SW_80STORE      0x08
+#define IIE_SW_PAGE2        0x10
+#define IIE_SW_HIRES        0x20
+#define IIE_SW_INTCXROM     0x40
+#define IIE_SW_SLOTC3ROM    0x80
+
+#define IIE_PAGE_SET_MASK   0x3F    // the switches that pick a page set
+#define IIE_NUM_PAGE_SETS   64
+#define IIE_MAPPED_PAGES    0xC0    // $0000-$BFFF
+
+struct iie_page_set_t {
+    uint8_t *read[IIE_MAPPED_PAGES];
+    uint8_t *write[IIE_MAPPED_PAGES];
+};
+
+struct iiememory_state_t {
+    uint8_t switches;                       // IIE_SW_*
+    iie_page_set_t page_sets[IIE_NUM_PAGE_SETS];
+
+    // $C800-$CFFF as the slots left it, while INTCXROM has it covered.
+    uint8_t *saved_C8_read[8];
+    uint8_t *saved_C8_write[8];
+    uint8_t saved_C8xx_slot;
+    // slot 3's own $C800 ROM / handler, what SLOTC3ROM switches back to.
+    uint8_t *saved_C8xx_rom_pages_3[8];
+    void (*saved_C8xx_handler_3)(cpu_state *cpu);
+    uint8_t *internal_C8_pages[8];
+
+    // the display's PAGE2 / HIRES handlers, which we sit in front of.
+    memory_read_handler display_read_C05x[4];
+    memory_write_handler display_write_C05x[4];
+};
+
+void init_mb_iie_memory(cpu_state *cpu, SlotType_t slot);
+void reset_iie_memory(cpu_state *cpu);
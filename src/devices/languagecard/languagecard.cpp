@@ -22,6 +22,7 @@
 #include "debug.hpp"
 
 #include "devices/languagecard/languagecard.hpp"
+#include "util/reset.hpp"
 
 
 /* uint8_t bank_selected = 0; */
@@ -66,7 +67,7 @@ static uint8_t _FF_WRITE_ENABLE = 0; // inverted sense */
 void set_memory_pages_based_on_flags(cpu_state *cpu) {
     languagecard_state_t *lc = (languagecard_state_t *)get_module_state(cpu, MODULE_LANGCARD);
 
-    uint8_t *bank = (lc->FF_BANK_1 == 1) ? cpu->main_ram_64 + 0xC000 : cpu->main_ram_64 + 0xD000;
+    uint8_t *bank = (lc->FF_BANK_1 == 1) ? lc->ram + 0xC000 : lc->ram + 0xD000;
     for (int i = 0; i < 16; i++) {
         if (lc->FF_READ_ENABLE) {
             // set pages_read[i] to bank[i*0x0100]
@@ -92,7 +93,7 @@ void set_memory_pages_based_on_flags(cpu_state *cpu) {
     for (int i = 0; i < 32; i++) {
         if (lc->FF_READ_ENABLE) {
             // set pages_read[i] to bank[i*0x0100]
-            cpu->memory->pages_read[i + 0xE0] = cpu->main_ram_64 + ((i+0xE0)*GS2_PAGE_SIZE);
+            cpu->memory->pages_read[i + 0xE0] = lc->ram + ((i+0xE0)*GS2_PAGE_SIZE);
             cpu->memory->page_info[i + 0xE0].type = MEM_RAM;
         } else { // reads == READ_ROM
             // set pages_read[i] to bank[i*0x0100]
@@ -101,7 +102,7 @@ void set_memory_pages_based_on_flags(cpu_state *cpu) {
         }
 
         if (!lc->_FF_WRITE_ENABLE) {
-            cpu->memory->pages_write[i + 0xE0] = cpu->main_ram_64 + ((i+0xE0)*GS2_PAGE_SIZE);
+            cpu->memory->pages_write[i + 0xE0] = lc->ram + ((i+0xE0)*GS2_PAGE_SIZE);
             cpu->memory->page_info[i + 0xE0].type = MEM_RAM;
             cpu->memory->page_info[i + 0xE0].can_write = 1;
         } else { // writes == WRITE_NONE - set it to the ROM and can_write = 0
@@ -247,8 +248,10 @@ void init_slot_languagecard(cpu_state *cpu, SlotType_t slot) {
     lc->FF_PRE_WRITE = 0;
     lc->FF_READ_ENABLE = 0;
     lc->_FF_WRITE_ENABLE = 0;
+    lc->ram = cpu->main_ram_64;
 
     set_module_state(cpu, MODULE_LANGCARD, lc);
+    register_reset_handler(cpu, reset_languagecard);
 
     register_C0xx_memory_read_handler(0xC011, languagecard_read_C011);
     register_C0xx_memory_read_handler(0xC012, languagecard_read_C012);
@@ -261,6 +264,11 @@ void init_slot_languagecard(cpu_state *cpu, SlotType_t slot) {
     set_memory_pages_based_on_flags(cpu);
 }
 
+/**
+ * The card keeps its configuration across RESET, but system_reset has just
+ * put the ROM back at $D000-$FFFF, so map the card back in over it.
+ * (On a IIe the MMU does reset it; reset_iie_memory handles that.)
+ */
 void reset_languagecard(cpu_state *cpu) {
-
+    set_memory_pages_based_on_flags(cpu);
 }
\ No newline at end of file
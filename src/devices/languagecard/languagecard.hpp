@@ -71,7 +71,9 @@ struct languagecard_state_t {
     uint32_t FF_READ_ENABLE;
     uint32_t FF_PRE_WRITE;
     uint32_t _FF_WRITE_ENABLE;
+    uint8_t *ram;   // main_ram_64, or aux_ram_64 on a IIe with ALTZP on. bank 1 at +$C000, bank 2 at +$D000.
 };
 
 void init_slot_languagecard(cpu_state *cpu, SlotType_t slot);
 void reset_languagecard(cpu_state *cpu);
+void set_memory_pages_based_on_flags(cpu_state *cpu);
@@ -66,4 +66,12 @@ void loader_execute(cpu_state *cpu) {
     }
 
     free(memory_chunk);
-}
\ No newline at end of file
+}
+
+/**
+ * Load the file and start executing it there, instead of wherever reset went.
+ */
+void loader_run(cpu_state *cpu) {
+    loader_execute(cpu);
+    cpu->pc = loader_address;
+}
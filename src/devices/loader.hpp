@@ -22,3 +22,4 @@
 
 void loader_execute(cpu_state *cpu);
 void loader_set_file_info(char *filename, uint16_t address);
+void loader_run(cpu_state *cpu);
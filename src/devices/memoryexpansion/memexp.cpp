@@ -15,6 +15,13 @@
  *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "gs2.hpp"
 #include "cpu.hpp"
 #include "bus.hpp"
@@ -22,6 +29,78 @@
 #include "memory.hpp"
 #include "debug.hpp"
 
+/**
+ * Card configuration - set from the command line or a system config before the card is powered on.
+ * If a backing file is set, the card RAM is mmap'd from it (MAP_SHARED) so the
+ * RAM disk survives across runs. The OS flushes dirty pages on its own schedule;
+ * we only msync at power-off.
+ */
+static uint32_t memexp_config_size = MEMEXP_SIZE;
+static const char *memexp_config_backing_file = nullptr;
+
+void memexp_set_size(uint32_t size) {
+    // round up to a power of 2, and clamp to what the card can address.
+    uint32_t sz = MEMEXP_MIN_SIZE;
+    while (sz < size && sz < MEMEXP_MAX_SIZE) {
+        sz <<= 1;
+    }
+    if (sz != size) {
+        fprintf(stderr, "memexp: size %u not supported, using %u\n", size, sz);
+    }
+    memexp_config_size = sz;
+}
+
+void memexp_set_backing_file(const char *filename) {
+    memexp_config_backing_file = filename;
+}
+
+/**
+ * [slotN] settings from a system config: size (in KB, like -M) and file (like
+ * -m). The config loader only takes one memexp card, so these are that
+ * card's settings whatever the slot. value has to outlive power-on; the
+ * loaded config keeps it.
+ */
+bool memexp_set_option(SlotType_t slot, const char *key, const char *value) {
+    if (strcmp(key, "size") == 0) {
+        char *end;
+        unsigned long kb = strtoul(value, &end, 10);
+        if (*value == 0 || *end != 0 || kb == 0) return false;
+        memexp_set_size(kb * 1024);
+        return true;
+    }
+    if (strcmp(key, "file") == 0) {
+        memexp_set_backing_file(value);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * map the backing file into memory, growing it to the card size if needed.
+ * returns nullptr on any failure; caller falls back to heap memory.
+ */
+static uint8_t *memexp_map_backing_file(const char *filename, uint32_t size, int *fd_out) {
+    int fd = open(filename, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        perror("memexp: open backing file");
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (st.st_size < (off_t)size && ftruncate(fd, size) < 0)) {
+        perror("memexp: size backing file");
+        close(fd);
+        return nullptr;
+    }
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        perror("memexp: mmap backing file");
+        close(fd);
+        return nullptr;
+    }
+    *fd_out = fd;
+    return (uint8_t *)p;
+}
+
 void memexp_write_C0x0(cpu_state *cpu, uint16_t addr, uint8_t data) {
     memexp_data * memexp_d = (memexp_data *)get_module_state(cpu, MODULE_MEMEXP);
     uint8_t old_lo = memexp_d->addr_low;
@@ -65,43 +144,53 @@ uint8_t memexp_read_C0x1(cpu_state *cpu, uint16_t addr) {
 
 uint8_t memexp_read_C0x2(cpu_state *cpu, uint16_t addr) {
     memexp_data * memexp_d = (memexp_data *)get_module_state(cpu, MODULE_MEMEXP);
-    return memexp_d->addr_high | 0xF0; // hi nybble here is always 0xF if card has 1MB or less.
+    return memexp_d->addr_high | memexp_d->high_fill; // hi nybble here is always 0xF if card has 1MB or less.
 }
 
+/**
+ * Data port. This is the hot path - ProDOS RAM disk driver hammers it in tight loops.
+ * The three address bytes share storage with the 32-bit addr, so we never
+ * reassemble them; just mask to the card size and bump.
+ */
 uint8_t memexp_read_C0x3(cpu_state *cpu, uint16_t addr) {
     memexp_data * memexp_d = (memexp_data *)get_module_state(cpu, MODULE_MEMEXP);
-    uint8_t data = memexp_d->data[memexp_d->addr];
+    uint32_t a = memexp_d->addr;
+    memexp_d->addr = a + 1;
+    uint8_t data = memexp_d->data[a & memexp_d->addr_mask];
     if (DEBUG(DEBUG_MEMEXP)) {
-        printf("memexp_read_C0x3 %x => %x\n", memexp_d->addr, data);
+        printf("memexp_read_C0x3 %x => %x\n", a, data);
     }
-    memexp_d->addr++;
     return data;
 }
 
 void memexp_write_C0x3(cpu_state *cpu, uint16_t addr, uint8_t data) {
     memexp_data * memexp_d = (memexp_data *)get_module_state(cpu, MODULE_MEMEXP);
-    memexp_d->data[memexp_d->addr] = data;
-    if (DEBUG(DEBUG_MEMEXP)) {
-        printf("memexp_write_C0x3 %x => %x\n", data, memexp_d->addr);
-    }
-    memexp_d->addr++;
-}
-
-void map_rom_memexp(cpu_state *cpu) {
-    memexp_data * memexp_d = (memexp_data *)get_module_state(cpu, MODULE_MEMEXP);
-    uint8_t *dp = memexp_d->rom->get_data();
-    for (uint8_t page = 0; page < 8; page++) {
-        memory_map_page_both(cpu, page + 0xC8, dp + 0x800 + (page * 0x100), MEM_IO);
-    }
+    uint32_t a = memexp_d->addr;
+    memexp_d->addr = a + 1;
+    memexp_d->data[a & memexp_d->addr_mask] = data;
     if (DEBUG(DEBUG_MEMEXP)) {
-        printf("mapped in memexp $C800-$CFFF\n");
+        printf("memexp_write_C0x3 %x => %x\n", data, a);
     }
 }
 
 void init_slot_memexp(cpu_state *cpu, SlotType_t slot) {
     memexp_data * memexp_d = new memexp_data;
     // set in CPU so we can reference later
-    memexp_d->data = new uint8_t[MEMEXP_SIZE];
+    memexp_d->size = memexp_config_size;
+    memexp_d->addr_mask = memexp_d->size - 1;
+    // unused high address lines read back as 1s. On a 1MB card that's the whole top nybble.
+    memexp_d->high_fill = (memexp_d->size <= MEMEXP_SIZE) ? 0xF0 : (uint8_t)~(memexp_d->addr_mask >> 16);
+    memexp_d->backing_fd = -1;
+    memexp_d->data = nullptr;
+    if (memexp_config_backing_file) {
+        memexp_d->data = memexp_map_backing_file(memexp_config_backing_file, memexp_d->size, &memexp_d->backing_fd);
+        if (memexp_d->data) {
+            fprintf(stdout, "memexp: %u bytes backed by %s\n", memexp_d->size, memexp_config_backing_file);
+        }
+    }
+    if (memexp_d->data == nullptr) {
+        memexp_d->data = new uint8_t[memexp_d->size];
+    }
     memexp_d->addr = 0;
 
     ResourceFile *rom = new ResourceFile("roms/cards/memexp/memexp.rom", READ_ONLY);
@@ -138,5 +227,21 @@ void init_slot_memexp(cpu_state *cpu, SlotType_t slot) {
         raw_memory_write(cpu, 0xC000 + (slot * 0x0100) + i, rom_data[i + (slot * 0x100)]);
     }
 
-    register_C8xx_handler(cpu, slot, map_rom_memexp);
-}
\ No newline at end of file
+    register_C8xx_rom(cpu, slot, rom_data + 0x800);
+}
+
+void power_off_memexp(cpu_state *cpu, SlotType_t slot) {
+    memexp_data * memexp_d = (memexp_data *)get_module_state(cpu, MODULE_MEMEXP);
+    if (memexp_d == nullptr) return;
+
+    if (memexp_d->backing_fd >= 0) {
+        msync(memexp_d->data, memexp_d->size, MS_ASYNC);
+        munmap(memexp_d->data, memexp_d->size);
+        close(memexp_d->backing_fd);
+    } else {
+        delete[] memexp_d->data;
+    }
+    memexp_d->data = nullptr;
+    set_module_state(cpu, MODULE_MEMEXP, nullptr);
+    delete memexp_d;
+}
@@ -15,6 +15,8 @@
  *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#pragma once
+
 #include "gs2.hpp"
 #include "cpu.hpp"
 #include "util/ResourceFile.hpp"
@@ -26,6 +28,8 @@
 #define MEMEXP_BANK_SELECT 0x000F
 
 #define MEMEXP_SIZE 1024*1024
+#define MEMEXP_MIN_SIZE 256*1024
+#define MEMEXP_MAX_SIZE 8*1024*1024
 
 typedef struct memexp_data {
     union {
@@ -38,7 +42,15 @@ typedef struct memexp_data {
         };
     };
     uint8_t *data;
+    uint32_t size;
+    uint32_t addr_mask;     // size - 1. size is always a power of 2.
+    uint8_t high_fill;      // bits forced on when reading $C0x2 - unused address lines read as 1.
+    int backing_fd;         // -1 if data is plain heap memory.
     ResourceFile *rom;
 } memexp_data;
 
-void init_slot_memexp(cpu_state *cpu, SlotType_t slot);
\ No newline at end of file
+void memexp_set_size(uint32_t size);
+void memexp_set_backing_file(const char *filename);
+bool memexp_set_option(SlotType_t slot, const char *key, const char *value);
+void init_slot_memexp(cpu_state *cpu, SlotType_t slot);
+void power_off_memexp(cpu_state *cpu, SlotType_t slot);
\ No newline at end of file
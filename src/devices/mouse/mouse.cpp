@@ -0,0 +1,268 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "gs2.hpp"
+#include "cpu.hpp"
+#include "bus.hpp"
+#include "memory.hpp"
+#include "debug.hpp"
+#include "devices/mouse/mouse.hpp"
+
+/**
+ * Apple Mouse Interface Card
+ *
+ * The real card has a 6805 microcontroller tracking the mouse and a chunk of
+ * 6502 firmware talking to it through a PIA. We don't emulate any of that.
+ * Instead the slot ROM is generated here: the ID bytes ProDOS / AppleMouse
+ * software look for, the entry point table at $Cn12, and one tiny stub per entry:
+ *
+ *     STA $C0n0+entry
+ *     RTS
+ *
+ * The write lands in mouse_entry() below, which does the whole firmware call
+ * against the screen holes and sets carry for the return. STA doesn't touch
+ * flags, so carry survives back to the caller.
+ *
+ * Host mouse motion is accumulated as it arrives, and folded into the card
+ * position once per frame in mouse_frame(), which is also our VBL.
+ */
+
+#define MOUSE_PASCAL_STUB 0x28
+#define MOUSE_ENTRY_STUBS 0x30
+
+static mouse_state_t *mouse_get_state(cpu_state *cpu) {
+    // not get_module_state: host events come in whether or not the card is installed.
+    return (mouse_state_t *)cpu->module_store[MODULE_MOUSE];
+}
+
+static void mouse_build_firmware(uint8_t *rom, uint8_t slot) {
+    memset(rom, 0, 256);
+
+    rom[0x00] = 0x60;   // RTS. no PR#/IN# support.
+
+    // ID bytes
+    rom[0x05] = 0x38;
+    rom[0x07] = 0x18;
+    rom[0x0B] = 0x01;
+    rom[0x0C] = 0x20;   // mouse
+    rom[0xFB] = 0xD6;
+
+    // Pascal 1.1 entries - not supported, return no error.
+    for (int i = 0x0D; i <= 0x11; i++) {
+        rom[i] = MOUSE_PASCAL_STUB;
+    }
+    rom[MOUSE_PASCAL_STUB + 0] = 0xA2;  // LDX #$00
+    rom[MOUSE_PASCAL_STUB + 1] = 0x00;
+    rom[MOUSE_PASCAL_STUB + 2] = 0x60;  // RTS
+
+    for (int entry = 0; entry < MOUSE_NUM_ENTRIES; entry++) {
+        uint8_t stub = MOUSE_ENTRY_STUBS + (entry * 4);
+        rom[0x12 + entry] = stub;
+        rom[stub + 0] = 0x8D;                               // STA abs
+        rom[stub + 1] = 0x80 + (slot * 0x10) + entry;
+        rom[stub + 2] = 0xC0;
+        rom[stub + 3] = 0x60;                               // RTS
+    }
+}
+
+static void mouse_update_irq(cpu_state *cpu, mouse_state_t *ms) {
+    cpu_set_irq(cpu, ms->slot, (ms->mode & MOUSE_MODE_ON) && ms->int_pending);
+}
+
+static void mouse_clamp_position(mouse_state_t *ms) {
+    if (ms->x < ms->min_x) ms->x = ms->min_x;
+    if (ms->x > ms->max_x) ms->x = ms->max_x;
+    if (ms->y < ms->min_y) ms->y = ms->min_y;
+    if (ms->y > ms->max_y) ms->y = ms->max_y;
+}
+
+static void mouse_write_position(cpu_state *cpu, mouse_state_t *ms) {
+    uint8_t n = ms->slot;
+    raw_memory_write(cpu, MOUSE_HOLE_X_LO + n, ms->x & 0xFF);
+    raw_memory_write(cpu, MOUSE_HOLE_X_HI + n, (ms->x >> 8) & 0xFF);
+    raw_memory_write(cpu, MOUSE_HOLE_Y_LO + n, ms->y & 0xFF);
+    raw_memory_write(cpu, MOUSE_HOLE_Y_HI + n, (ms->y >> 8) & 0xFF);
+}
+
+static void mouse_reset_state(mouse_state_t *ms) {
+    ms->mode = 0;
+    ms->int_pending = 0;
+    ms->int_status = 0;
+    ms->x = ms->y = 0;
+    ms->min_x = ms->min_y = 0;
+    ms->max_x = ms->max_y = 1023;
+    ms->moved = false;
+    ms->last_read_button = ms->button;
+}
+
+void mouse_entry(cpu_state *cpu, uint16_t addr, uint8_t data) {
+    mouse_state_t *ms = (mouse_state_t *)get_module_state(cpu, MODULE_MOUSE);
+    uint8_t n = ms->slot;
+    uint8_t entry = addr & 0x0F;
+
+    if (DEBUG(DEBUG_MOUSE)) {
+        printf("mouse entry %d A=%02X\n", entry, data);
+    }
+
+    cpu->C = 0;
+    switch (entry) {
+        case MOUSE_SETMOUSE:
+            if (data > 0x0F) {
+                cpu->C = 1;
+                break;
+            }
+            ms->mode = data;
+            raw_memory_write(cpu, MOUSE_HOLE_MODE + n, ms->mode);
+            break;
+
+        case MOUSE_SERVEMOUSE:
+            if (ms->int_pending == 0) {
+                cpu->C = 1;     // not ours
+                break;
+            }
+            ms->int_status = ms->int_pending;
+            ms->int_pending = 0;
+            raw_memory_write(cpu, MOUSE_HOLE_STATUS + n,
+                (raw_memory_read(cpu, MOUSE_HOLE_STATUS + n) & ~0x0E) | ms->int_status);
+            break;
+
+        case MOUSE_READMOUSE: {
+            uint8_t status = ms->int_status;
+            if (ms->button) status |= MOUSE_STATUS_BTN;
+            if (ms->last_read_button) status |= MOUSE_STATUS_LASTBTN;
+            if (ms->moved) status |= MOUSE_STATUS_MOVED;
+            mouse_write_position(cpu, ms);
+            raw_memory_write(cpu, MOUSE_HOLE_STATUS + n, status);
+            ms->last_read_button = ms->button;
+            ms->moved = false;
+            ms->int_status = 0;
+            break;
+        }
+
+        case MOUSE_CLEARMOUSE:
+            ms->x = ms->y = 0;
+            mouse_write_position(cpu, ms);
+            break;
+
+        case MOUSE_POSMOUSE:
+            ms->x = raw_memory_read(cpu, MOUSE_HOLE_X_LO + n) | (raw_memory_read(cpu, MOUSE_HOLE_X_HI + n) << 8);
+            ms->y = raw_memory_read(cpu, MOUSE_HOLE_Y_LO + n) | (raw_memory_read(cpu, MOUSE_HOLE_Y_HI + n) << 8);
+            break;
+
+        case MOUSE_CLAMPMOUSE: {
+            // clamp values are in the slot-0 screen holes regardless of slot.
+            int16_t lo = raw_memory_read(cpu, MOUSE_HOLE_X_LO) | (raw_memory_read(cpu, MOUSE_HOLE_X_HI) << 8);
+            int16_t hi = raw_memory_read(cpu, MOUSE_HOLE_Y_LO) | (raw_memory_read(cpu, MOUSE_HOLE_Y_HI) << 8);
+            if (data == 0) {
+                ms->min_x = lo;
+                ms->max_x = hi;
+            } else {
+                ms->min_y = lo;
+                ms->max_y = hi;
+            }
+            mouse_clamp_position(ms);
+            break;
+        }
+
+        case MOUSE_HOMEMOUSE:
+            ms->x = ms->min_x;
+            ms->y = ms->min_y;
+            mouse_write_position(cpu, ms);
+            break;
+
+        case MOUSE_INITMOUSE:
+            mouse_reset_state(ms);
+            mouse_write_position(cpu, ms);
+            raw_memory_write(cpu, MOUSE_HOLE_STATUS + n, 0);
+            raw_memory_write(cpu, MOUSE_HOLE_MODE + n, 0);
+            break;
+    }
+    mouse_update_irq(cpu, ms);
+}
+
+/**
+ * Called from the host event loop. Cheap - just accumulate; the card only
+ * sees it at the next frame.
+ */
+void mouse_motion(cpu_state *cpu, float dx, float dy) {
+    mouse_state_t *ms = mouse_get_state(cpu);
+    if (ms == nullptr) return;
+    ms->delta_x += dx;
+    ms->delta_y += dy;
+}
+
+void mouse_button(cpu_state *cpu, bool down) {
+    mouse_state_t *ms = mouse_get_state(cpu);
+    if (ms == nullptr) return;
+    ms->host_button = down;
+}
+
+/**
+ * Once per emulated frame. Fold in accumulated motion, and raise whatever
+ * interrupts the guest asked for. This is also the card's VBL.
+ */
+void mouse_frame(cpu_state *cpu) {
+    mouse_state_t *ms = mouse_get_state(cpu);
+    if (ms == nullptr) return;
+
+    int dx = (int)ms->delta_x;
+    int dy = (int)ms->delta_y;
+    ms->delta_x -= dx;          // keep the fractional part for next frame
+    ms->delta_y -= dy;
+
+    int16_t old_x = ms->x;
+    int16_t old_y = ms->y;
+    ms->x += dx;
+    ms->y += dy;
+    mouse_clamp_position(ms);
+    bool moved = (ms->x != old_x) || (ms->y != old_y);
+    if (moved) ms->moved = true;
+
+    bool button_changed = (ms->host_button != ms->button);
+    ms->button = ms->host_button;
+
+    if (ms->mode & MOUSE_MODE_ON) {
+        if (moved && (ms->mode & MOUSE_MODE_INT_MOVE)) ms->int_pending |= MOUSE_STATUS_INT_MOVE;
+        if (button_changed && (ms->mode & MOUSE_MODE_INT_BTN)) ms->int_pending |= MOUSE_STATUS_INT_BTN;
+        if (ms->mode & MOUSE_MODE_INT_VBL) ms->int_pending |= MOUSE_STATUS_INT_VBL;
+    }
+    mouse_update_irq(cpu, ms);
+}
+
+void init_slot_mouse(cpu_state *cpu, SlotType_t slot) {
+    mouse_state_t *ms = new mouse_state_t;
+    memset(ms, 0, sizeof(mouse_state_t));
+    ms->slot = slot;
+    mouse_reset_state(ms);
+
+    set_module_state(cpu, MODULE_MOUSE, ms);
+
+    fprintf(stdout, "init_slot_mouse %d\n", slot);
+
+    uint16_t slot_base = 0xC080 + (slot * 0x10);
+    for (int entry = 0; entry < MOUSE_NUM_ENTRIES; entry++) {
+        register_C0xx_memory_write_handler(slot_base + entry, mouse_entry);
+    }
+
+    uint8_t rom[256];
+    mouse_build_firmware(rom, slot);
+    for (int i = 0; i < 256; i++) {
+        raw_memory_write(cpu, 0xC000 + (slot * 0x0100) + i, rom[i]);
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "gs2.hpp"
+#include "cpu.hpp"
+
+/**
+ * Apple Mouse Interface Card. Firmware is HLE: each entry point in the
+ * slot ROM is a single STA to one of our $C0nX registers followed by RTS,
+ * so the whole firmware call is handled host-side in one bus write.
+ */
+
+/* Register offsets from $C080 + slot*16. Same order as the entry table at $Cn12. */
+#define MOUSE_SETMOUSE    0x00
+#define MOUSE_SERVEMOUSE  0x01
+#define MOUSE_READMOUSE   0x02
+#define MOUSE_CLEARMOUSE  0x03
+#define MOUSE_POSMOUSE    0x04
+#define MOUSE_CLAMPMOUSE  0x05
+#define MOUSE_HOMEMOUSE   0x06
+#define MOUSE_INITMOUSE   0x07
+#define MOUSE_NUM_ENTRIES 8
+
+/* Mode byte (SETMOUSE) */
+#define MOUSE_MODE_ON       0x01
+#define MOUSE_MODE_INT_MOVE 0x02
+#define MOUSE_MODE_INT_BTN  0x04
+#define MOUSE_MODE_INT_VBL  0x08
+
+/* Status byte ($0778+n) */
+#define MOUSE_STATUS_INT_MOVE 0x02
+#define MOUSE_STATUS_INT_BTN  0x04
+#define MOUSE_STATUS_INT_VBL  0x08
+#define MOUSE_STATUS_MOVED    0x20
+#define MOUSE_STATUS_LASTBTN  0x40
+#define MOUSE_STATUS_BTN      0x80
+
+/* Screen holes. Add slot number except for the clamp values. */
+#define MOUSE_HOLE_X_LO   0x0478
+#define MOUSE_HOLE_Y_LO   0x04F8
+#define MOUSE_HOLE_X_HI   0x0578
+#define MOUSE_HOLE_Y_HI   0x05F8
+#define MOUSE_HOLE_STATUS 0x0778
+#define MOUSE_HOLE_MODE   0x07F8
+
+struct mouse_state_t {
+    uint8_t slot;
+    uint8_t mode;
+    uint8_t int_pending;    // interrupt reasons not yet collected by SERVEMOUSE
+    uint8_t int_status;     // interrupt reasons reported by the last SERVEMOUSE
+
+    int16_t x, y;
+    int16_t min_x, max_x;
+    int16_t min_y, max_y;
+
+    bool button;            // button state as of the last frame
+    bool last_read_button;  // button state as of the last READMOUSE
+    bool moved;             // moved since the last READMOUSE
+
+    /* host side - accumulated between frames */
+    float delta_x, delta_y;
+    bool host_button;
+};
+
+void init_slot_mouse(cpu_state *cpu, SlotType_t slot);
+void mouse_motion(cpu_state *cpu, float dx, float dy);
+void mouse_button(cpu_state *cpu, bool down);
+void mouse_frame(cpu_state *cpu);
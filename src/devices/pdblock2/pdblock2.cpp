@@ -16,6 +16,8 @@
  */
 
 #include <stdio.h>
+#include <SDL3/SDL.h>
+
 #include "gs2.hpp"
 #include "cpu.hpp"
 #include "bus.hpp"
@@ -25,6 +27,7 @@
 #include "util/media.hpp"
 #include "util/ResourceFile.hpp"
 #include "util/mount.hpp"
+#include "util/reset.hpp"
 
 void pdblock2_print_cmdbuffer(pdblock_cmd_buffer *pdb) {
     printf("PD_CMD_BUFFER: ");
@@ -77,6 +80,18 @@ uint8_t pdblock2_status(cpu_state *cpu, uint8_t slot, uint8_t drive) {
  * that take into account the memory map, so, we can write data into
  * any bank selected as the CPU (or a 'DMA' device like us) would see it.
  */
+/**
+ * Let observers know about block traffic. A busy drive can do thousands of
+ * blocks per frame in free-run; nobody needs to hear about every one of them.
+ */
+#define PD_EVENT_INTERVAL_CYCLES 17008
+
+void pdblock2_publish_access(cpu_state *cpu, media_t &md, uint8_t slot, uint8_t drive, drive_event_type_t type, uint16_t block) {
+    if (md.last_event_cycle != 0 && cpu->cycles - md.last_event_cycle < PD_EVENT_INTERVAL_CYCLES) return;
+    md.last_event_cycle = cpu->cycles;
+    cpu->mounts->publish((slot << 8) | drive, type, block);
+}
+
 void pdblock2_read_block(cpu_state *cpu, uint8_t slot, uint8_t drive, uint16_t block, uint16_t addr) {
     pdblock2_data * pdblock_d = (pdblock2_data *)get_module_state(cpu, MODULE_PD_BLOCK2);
 
@@ -97,6 +112,7 @@ void pdblock2_read_block(cpu_state *cpu, uint8_t slot, uint8_t drive, uint16_t b
     }
     pdblock_d->prodosblockdevices[slot][drive].last_block_accessed = block;
     pdblock_d->prodosblockdevices[slot][drive].last_block_access_time = SDL_GetTicksNS();
+    pdblock2_publish_access(cpu, pdblock_d->prodosblockdevices[slot][drive], slot, drive, DRIVE_EVENT_BLOCK_READ, block);
     //debug_dump_memory(cpu, addr, addr + media[slot][drive].block_size);
 }
 
@@ -116,6 +132,7 @@ void pdblock2_write_block(cpu_state *cpu, uint8_t slot, uint8_t drive, uint16_t
     fwrite(block_buffer, 1, media->block_size, fp);
     pdblock_d->prodosblockdevices[slot][drive].last_block_accessed = block;
     pdblock_d->prodosblockdevices[slot][drive].last_block_access_time = SDL_GetTicksNS();
+    pdblock2_publish_access(cpu, pdblock_d->prodosblockdevices[slot][drive], slot, drive, DRIVE_EVENT_BLOCK_WRITE, block);
 }
 
 void pdblock2_execute(cpu_state *cpu) {
@@ -179,18 +196,39 @@ void pdblock2_execute(cpu_state *cpu) {
     }
 }
 
-void mount_pdblock2(cpu_state *cpu, uint8_t slot, uint8_t drive, media_descriptor *media) {
+int mount_pdblock2(cpu_state *cpu, uint8_t slot, uint8_t drive, media_descriptor *media) {
     pdblock2_data * pdblock_d = (pdblock2_data *)get_module_state(cpu, MODULE_PD_BLOCK2);
 
     if (DEBUG(DEBUG_PD_BLOCK)) printf("Mounting ProDOS block device %s slot %d drive %d\n", media->filename, slot, drive);
 
+    if (pdblock_d->prodosblockdevices[slot][drive].file != nullptr) {
+        unmount_pdblock2(cpu, slot, drive);
+    }
+
     FILE *fp = fopen(media->filename, "r+b");
     if (fp == nullptr) {
         fprintf(stderr, "Could not open ProDOS block device file: %s\n", media->filename);
-        return;
+        return -1;
     }
     pdblock_d->prodosblockdevices[slot][drive].file = fp;
     pdblock_d->prodosblockdevices[slot][drive].media = media;
+    cpu->mounts->publish((slot << 8) | drive, DRIVE_EVENT_MOUNT, 0, media->filestub);
+    return 0;
+}
+
+/* block writes go straight to the file, so all there is to flush is stdio's buffer. */
+void unmount_pdblock2(cpu_state *cpu, uint8_t slot, uint8_t drive) {
+    pdblock2_data * pdblock_d = (pdblock2_data *)get_module_state(cpu, MODULE_PD_BLOCK2);
+    media_t &seldrive = pdblock_d->prodosblockdevices[slot][drive];
+
+    if (seldrive.file == nullptr) {
+        return;
+    }
+    fclose(seldrive.file);
+    seldrive.file = nullptr;
+    seldrive.media = nullptr;
+    seldrive.last_block_accessed = 0;
+    cpu->mounts->publish((slot << 8) | drive, DRIVE_EVENT_UNMOUNT);
 }
 
 void pdblock2_write_C0x0(cpu_state *cpu, uint16_t addr, uint8_t data) {
@@ -234,20 +272,26 @@ uint8_t pdblock2_read_C0x0(cpu_state *cpu, uint16_t addr) {
 void init_pdblock2(cpu_state *cpu, SlotType_t slot)
 {
     if (DEBUG(DEBUG_PD_BLOCK)) printf("Initializing ProDOS Block2 slot %d\n", slot);
-    pdblock2_data * pdblock_d = new pdblock2_data;
-    // set in CPU so we can reference later
-    set_module_state(cpu, MODULE_PD_BLOCK2, pdblock_d);
-
-    ResourceFile *rom = new ResourceFile("roms/cards/pdblock2/pdblock2.rom", READ_ONLY);
-    if (rom == nullptr) {
-        fprintf(stderr, "Failed to load pdblock2.rom\n");
-        return;
+    // shared by every pdblock2 card: the drives are indexed by slot, and the ROM is the same.
+    pdblock2_data * pdblock_d = (pdblock2_data *)get_module_state(cpu, MODULE_PD_BLOCK2);
+    if (pdblock_d == nullptr) {
+        pdblock_d = new pdblock2_data();
+        // set in CPU so we can reference later
+        set_module_state(cpu, MODULE_PD_BLOCK2, pdblock_d);
+
+        ResourceFile *rom = new ResourceFile("roms/cards/pdblock2/pdblock2.rom", READ_ONLY);
+        if (rom == nullptr) {
+            fprintf(stderr, "Failed to load pdblock2.rom\n");
+            return;
+        }
+        rom->load();
+        pdblock_d->rom = (uint8_t *)(rom->get_data());
     }
-    rom->load();
-    pdblock_d->rom = (uint8_t *)(rom->get_data());
+    pdblock_d->prodosblockdevices[slot][0] = {};
+    pdblock_d->prodosblockdevices[slot][1] = {};
 
     // memory-map the page. Refactor to have a method to get and set memory map.
-    uint8_t *rom_data = (uint8_t *)(rom->get_data());
+    uint8_t *rom_data = pdblock_d->rom;
 
     // load the firmware into the slot memory -- refactor this
     for (int i = 0; i < 256; i++) {
@@ -262,4 +306,22 @@ void init_pdblock2(cpu_state *cpu, SlotType_t slot)
     register_C0xx_memory_read_handler((slot * 0x10) + PD_STATUS1_GET, pdblock2_read_C0x0);
     register_C0xx_memory_read_handler((slot * 0x10) + PD_STATUS2_GET, pdblock2_read_C0x0);
 
+    register_reset_handler(cpu, pdblock2_reset);
+}
+
+/* drop any half-sent command, and get writes out to the image files. */
+void pdblock2_reset(cpu_state *cpu) {
+    pdblock2_data * pdblock_d = (pdblock2_data *)get_module_state(cpu, MODULE_PD_BLOCK2);
+
+    pdblock_d->cmd_buffer.index = 0;
+    pdblock_d->cmd_buffer.error = 0;
+    pdblock_d->cmd_buffer.status1 = 0;
+    pdblock_d->cmd_buffer.status2 = 0;
+    for (int slot = 0; slot < 8; slot++) {
+        for (int drive = 0; drive < 2; drive++) {
+            if (pdblock_d->prodosblockdevices[slot][drive].file) {
+                fflush(pdblock_d->prodosblockdevices[slot][drive].file);
+            }
+        }
+    }
 }
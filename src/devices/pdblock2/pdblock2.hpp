@@ -35,6 +35,7 @@ typedef struct media_t {
     media_descriptor *media;
     int last_block_accessed;
     uint64_t last_block_access_time;
+    uint64_t last_event_cycle;
 } media_t;
 
 
@@ -60,7 +61,7 @@ struct pdblock_cmd_buffer {
 struct pdblock2_data {
     uint8_t *rom;
     pdblock_cmd_buffer cmd_buffer;
-    media_t prodosblockdevices[7][2];
+    media_t prodosblockdevices[8][2];
 };
 
 enum pdblock_cmd {
@@ -84,5 +85,7 @@ enum pdblock_cmd {
 
 void pdblock2_execute(cpu_state *cpu);
 void init_pdblock2(cpu_state *cpu, SlotType_t slot);
-void mount_pdblock2(cpu_state *cpu, uint8_t slot, uint8_t drive, media_descriptor *media);
+void pdblock2_reset(cpu_state *cpu);
+int mount_pdblock2(cpu_state *cpu, uint8_t slot, uint8_t drive, media_descriptor *media);
+void unmount_pdblock2(cpu_state *cpu, uint8_t slot, uint8_t drive);
 drive_status_t pdblock2_osd_status(cpu_state *cpu, uint64_t key);
\ No newline at end of file
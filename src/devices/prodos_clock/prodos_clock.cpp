@@ -18,10 +18,12 @@
 #include <time.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "debug.hpp"
 
 #include "cpu.hpp"
+#include "clock.hpp"
 
 #include "bus.hpp"
 #include "memory.hpp"
@@ -29,6 +31,7 @@
 #include "prodos_clock.hpp"
 
 #include "util/ResourceFile.hpp"
+#include "util/wall_clock.hpp"
 
 
 /**
@@ -78,21 +81,38 @@ foo:
 
  */
 
-void prodos_clock_getln_handler(cpu_state *cpu, char *buf) {
-    time_t now = time(nullptr);
-    struct tm *tm = localtime(&now);
+/**
+ * The driver only wants minutes, so the string is formatted at most once per
+ * emulated second and reused in between - some programs poll the clock in a
+ * loop.
+ */
+static void prodos_clock_refresh(cpu_state *cpu, prodos_clock_state *st) {
+    uint64_t cycles_per_second = clock_mode_info[CLOCK_1_024MHZ].hz_rate;
+    if (st->valid && cpu->cycles - st->refreshed_at < cycles_per_second) {
+        return;
+    }
 
-    snprintf(buf, 255, "%02d,%02d,%02d,%02d,%02d\r", tm->tm_mon + 1, tm->tm_wday, tm->tm_mday, tm->tm_hour, tm->tm_min);
-    for (int i = 0; buf[i] != '\0'; i++) {
-        raw_memory_write(cpu, 0x200 + i, buf[i] | 0x80);
+    struct tm tm;
+    wall_clock_now(cpu, &tm);
+    st->len = snprintf(st->buf, sizeof(st->buf), "%02d,%02d,%02d,%02d,%02d\r", tm.tm_mon + 1, tm.tm_wday, tm.tm_mday, tm.tm_hour, tm.tm_min);
+    for (int i = 0; i < st->len; i++) {
+        st->buf[i] |= 0x80;
     }
+    st->valid = true;
+    st->refreshed_at = cpu->cycles;
+}
+
+/* into the GETLN buffer at $200, in one copy. Goes through the write map, so a IIe with RAMWRT on gets it in aux. */
+void prodos_clock_getln_handler(cpu_state *cpu, prodos_clock_state *st) {
+    prodos_clock_refresh(cpu, st);
+    memcpy(cpu->memory->pages_write[0x02], st->buf, st->len);
 }
 
 void prodos_clock_write_register(cpu_state *cpu, uint16_t address, uint8_t value) {
     prodos_clock_state * prodosclock_d = (prodos_clock_state *)get_module_state(cpu, MODULE_PRODOS_CLOCK);
-    fprintf(stderr, "prodos_clock_write_register: %04x %02x\n", address, value);
+    if (DEBUG(DEBUG_CLOCK)) printf("prodos_clock_write_register: %04x %02x\n", address, value);
     if (value == PRODOS_CLOCK_GETLN_TRIGGER) {
-        prodos_clock_getln_handler(cpu, prodosclock_d->buf);
+        prodos_clock_getln_handler(cpu, prodosclock_d);
     }
 }
 
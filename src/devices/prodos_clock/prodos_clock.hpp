@@ -26,7 +26,10 @@
 #define PRODOS_CLOCK_GETLN_TRIGGER 0xAE
 
 struct prodos_clock_state {
-    char buf[64];    
+    char buf[64];           // the last string handed out, "mo,da,dt,hr,mn\r" with the high bits set
+    int len = 0;
+    bool valid = false;
+    uint64_t refreshed_at = 0;  // cpu->cycles when buf was last formatted
 };
 
 void init_slot_prodosclock(cpu_state *cpu, SlotType_t slot);
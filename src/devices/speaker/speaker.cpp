@@ -39,6 +39,76 @@
  */
 
 
+/**
+ * Turn the speaker toggles queued for [cycle_window_start, cycle_window_end) into
+ * samples_count samples in out. No SDL in here, so it can be benchmarked or run headless.
+ */
+void speaker_synthesize(speaker_state_t *speaker_state, int16_t *out, uint64_t samples_count, uint64_t cycle_window_start, uint64_t cycle_window_end) {
+    EventBuffer *event_buffer = &speaker_state->event_buffer;
+    uint64_t cycles_per_sample = (cycle_window_end - cycle_window_start) / samples_count;
+
+    /**
+     * this is the more savvy Chris Torrance algorithm.
+     */
+    uint64_t event_tick;
+    int16_t contribution = 0;
+    uint64_t cyc = cycle_window_start;
+    for (uint64_t samp = 0; samp < samples_count; samp++) {
+        for (uint64_t cyc_i = 0; cyc_i < cycles_per_sample; cyc_i ++) {
+            event_buffer->peek_oldest(event_tick);
+            if (event_tick <= cyc) {
+                event_buffer->pop_oldest(event_tick);
+                speaker_state->polarity = -speaker_state->polarity;
+            }
+            contribution += speaker_state->polarity;
+            cyc++;
+        }
+ //       out[samp] = ((float)contribution / (float)cycles_per_sample) * 0x6000;
+        if (cycles_per_sample > 0) {  // Prevent division by zero
+            float sample_value = ((float)contribution / (float)cycles_per_sample) * 0x6000;
+            // Clamp the value to valid int16_t range
+            if (sample_value > 32767.0f) sample_value = 32767.0f;
+            if (sample_value < -32768.0f) sample_value = -32768.0f;
+            out[samp] = (int16_t)sample_value;
+            speaker_state->last_sample = (int16_t)sample_value;
+        } else {
+            out[samp] = speaker_state->last_sample;  // Safe default when we can't calculate
+        }
+        contribution = 0;
+    }
+}
+
+/**
+ * Drop the toggles up to cycle_window_end without making any samples. Used
+ * when there's no audio sink, and in free run where the speaker is muted.
+ */
+void audio_discard_frame(cpu_state *cpu, uint64_t cycle_window_end) {
+    speaker_state_t *speaker_state = (speaker_state_t *)get_module_state(cpu, MODULE_SPEAKER);
+    EventBuffer *event_buffer = &speaker_state->event_buffer;
+
+    uint64_t event_tick;
+    while (event_buffer->peek_oldest(event_tick) && event_tick < cycle_window_end) {
+        event_buffer->pop_oldest(event_tick);
+        speaker_state->polarity = -speaker_state->polarity;
+    }
+}
+
+/**
+ * Free run: the speaker is muted, but a -w capture still gets a frame's worth
+ * of samples per emulated frame, same as at 1MHz, so it plays back at pitch.
+ */
+void audio_capture_frame(cpu_state *cpu, uint64_t cycle_window_start, uint64_t cycle_window_end) {
+    speaker_state_t *speaker_state = (speaker_state_t *)get_module_state(cpu, MODULE_SPEAKER);
+
+    if (speaker_state->capture == nullptr) {
+        audio_discard_frame(cpu, cycle_window_end);
+        return;
+    }
+    uint64_t samples_count = 735;
+    speaker_synthesize(speaker_state, speaker_state->working_buffer, samples_count, cycle_window_start, cycle_window_end);
+    speaker_state->capture_samples += fwrite(speaker_state->working_buffer, sizeof(int16_t), samples_count, speaker_state->capture);
+}
+
 void audio_generate_frame(cpu_state *cpu, uint64_t cycle_window_start, uint64_t cycle_window_end) {
     speaker_state_t *speaker_state = (speaker_state_t *)get_module_state(cpu,MODULE_SPEAKER);
     int16_t *working_buffer = speaker_state->working_buffer;
@@ -48,7 +118,13 @@ void audio_generate_frame(cpu_state *cpu, uint64_t cycle_window_start, uint64_t
     static uint64_t ns_per_sample = 1000000000 / 44100;  // 22675.736
     static uint64_t ns_per_cycle = cpu->cycle_duration_ns; // must calculate from actual results in ludicrous speed
 
-    if (cycle_window_start == 0 && cycle_window_end == 0) {
+    // nobody to hear it and nothing recording: just let go of the toggles so the event buffer doesn't fill.
+    if (speaker_state->stream == nullptr && speaker_state->capture == nullptr) {
+        audio_discard_frame(cpu, cycle_window_end);
+        return;
+    }
+
+    if (speaker_state->stream && cycle_window_start == 0 && cycle_window_end == 0) {
         printf("audio_generate_frame: first time send empty frame and a bit more\n");
         memset(working_buffer, 0, 735 * sizeof(int16_t));
         SDL_PutAudioStreamData(speaker_state->stream, working_buffer, 735*sizeof(int16_t));
@@ -56,7 +132,7 @@ void audio_generate_frame(cpu_state *cpu, uint64_t cycle_window_start, uint64_t
         return;
     }
 
-    uint64_t queued_samples = SDL_GetAudioStreamQueued(speaker_state->stream);
+    uint64_t queued_samples = speaker_state->stream ? SDL_GetAudioStreamQueued(speaker_state->stream) : 735;
     if (queued_samples < 735) { printf("queue underrun %llu\n", queued_samples); 
         // attempt to calculate how much time slipped and generate that many samples
         for (int x = 0; x < 735; x++) {
@@ -81,37 +157,16 @@ void audio_generate_frame(cpu_state *cpu, uint64_t cycle_window_start, uint64_t
         <<  " cyc range: [" << cycle_window_start << " - " << cycle_window_end << "] evtq: " 
         << event_buffer->count << " qd_samp: " << queued_samples << "\n";
 
-    /**
-     * this is the more savvy Chris Torrance algorithm.
-     */
-    uint64_t event_tick;
-    int16_t contribution = 0;
-    uint64_t cyc = cycle_window_start;
-    for (uint64_t samp = 0; samp < samples_count; samp++) {
-        for (uint64_t cyc_i = 0; cyc_i < cycles_per_sample; cyc_i ++) {
-            event_buffer->peek_oldest(event_tick);
-            if (event_tick <= cyc) {
-                event_buffer->pop_oldest(event_tick);
-                speaker_state->polarity = -speaker_state->polarity;
-            }
-            contribution += speaker_state->polarity;
-            cyc++;
-        }
- //       working_buffer[samp] = ((float)contribution / (float)cycles_per_sample) * 0x6000;
-        if (cycles_per_sample > 0) {  // Prevent division by zero
-            float sample_value = ((float)contribution / (float)cycles_per_sample) * 0x6000;
-            // Clamp the value to valid int16_t range
-            if (sample_value > 32767.0f) sample_value = 32767.0f;
-            if (sample_value < -32768.0f) sample_value = -32768.0f;
-            working_buffer[samp] = (int16_t)sample_value;
-            speaker_state->last_sample = (int16_t)sample_value;
-        } else {
-            working_buffer[samp] = speaker_state->last_sample;  // Safe default when we can't calculate
-        }
-        contribution = 0;
+    speaker_synthesize(speaker_state, working_buffer, samples_count, cycle_window_start, cycle_window_end);
+
+    if (speaker_state->capture) {
+        speaker_state->capture_samples += fwrite(working_buffer, sizeof(int16_t), samples_count, speaker_state->capture);
     }
+
     // copy samples out to audio stream
-    SDL_PutAudioStreamData(speaker_state->stream, working_buffer, samples_count*sizeof(int16_t));
+    if (speaker_state->stream) {
+        SDL_PutAudioStreamData(speaker_state->stream, working_buffer, samples_count*sizeof(int16_t));
+    }
 }
 
 
@@ -149,8 +204,25 @@ void init_mb_speaker(cpu_state *cpu, SlotType_t slot) {
 
     set_module_state(cpu, MODULE_SPEAKER, speaker_state);
 
-	// Initialize SDL audio - is this right, to do this again here?
-	SDL_Init(SDL_INIT_AUDIO);
+    if (DEBUG(DEBUG_SPEAKER)) fprintf(stdout, "init_speaker\n");
+    for (uint16_t addr = 0xC030; addr <= 0xC03F; addr++) {
+        register_C0xx_memory_read_handler(addr, speaker_memory_read);
+        register_C0xx_memory_write_handler(addr, speaker_memory_write);
+    }
+
+    if (gs2_app_values.audio_capture) {
+        speaker_capture_open(speaker_state, gs2_app_values.audio_capture);
+    }
+
+    // the audio device itself isn't opened until the first speaker toggle - see speaker_start.
+}
+
+/**
+ * Bring up SDL audio and open the output stream. Done on first use rather than at
+ * boot, so programs that never click the speaker (and batch runs) don't pay for it.
+ */
+static void speaker_open_audio(speaker_state_t *speaker_state) {
+	SDL_InitSubSystem(SDL_INIT_AUDIO);
 	
     SDL_AudioSpec desired = {};
     desired.freq = 44100;
@@ -159,8 +231,6 @@ void init_mb_speaker(cpu_state *cpu, SlotType_t slot) {
     
     speaker_state->stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &desired, NULL, NULL);
 
-    std::cout << "SDL_OpenAudioDevice returned: " << speaker_state->device_id << "\n";
-
     if ( speaker_state->stream == nullptr )
     {
         std::cerr << "Error opening audio device: " << SDL_GetError() << std::endl;
@@ -168,23 +238,27 @@ void init_mb_speaker(cpu_state *cpu, SlotType_t slot) {
     }
 
     speaker_state->device_id = SDL_GetAudioStreamDevice(speaker_state->stream);
+    std::cout << "SDL_OpenAudioDevice returned: " << speaker_state->device_id << "\n";
     SDL_PauseAudioDevice(speaker_state->device_id);
 
     // prime the pump with a few frames of silence.
     memset(speaker_state->working_buffer, 0, 735 * sizeof(int16_t));
     SDL_PutAudioStreamData(speaker_state->stream, speaker_state->working_buffer, 735*sizeof(int16_t));
-
-    if (DEBUG(DEBUG_SPEAKER)) fprintf(stdout, "init_speaker\n");
-    for (uint16_t addr = 0xC030; addr <= 0xC03F; addr++) {
-        register_C0xx_memory_read_handler(addr, speaker_memory_read);
-        register_C0xx_memory_write_handler(addr, speaker_memory_write);
-    }
 }
 
 void speaker_start(cpu_state *cpu) {
     speaker_state_t *speaker_state = (speaker_state_t *)get_module_state(cpu, MODULE_SPEAKER);
     int16_t *working_buffer = speaker_state->working_buffer;
 
+    speaker_state->device_started = 1;
+
+    if (speaker_state->stream == nullptr && !gs2_app_values.no_audio) {
+        speaker_open_audio(speaker_state);
+    }
+    if (speaker_state->stream == nullptr) { // audio is off, or the device failed to open.
+        return;
+    }
+
     // Start audio playback
     // put a frame of blank audio into the buffer to prime the pump.
 
@@ -193,14 +267,17 @@ void speaker_start(cpu_state *cpu) {
     }
     memset(working_buffer, 0, SAMPLE_BUFFER_SIZE * sizeof(int16_t));
     SDL_PutAudioStreamData(speaker_state->stream, working_buffer, 735*sizeof(int16_t));
-
-    speaker_state->device_started = 1;
 }
 
 void speaker_stop(cpu_state *cpu) {
     speaker_state_t *speaker_state = (speaker_state_t *)get_module_state(cpu, MODULE_SPEAKER);
     int16_t *working_buffer = speaker_state->working_buffer;
 
+    if (speaker_state->stream == nullptr) {
+        speaker_state->device_started = 0;
+        return;
+    }
+
     // Stop audio playback
     memset(working_buffer, 0, SAMPLE_BUFFER_SIZE * sizeof(int16_t));
     SDL_PutAudioStreamData(speaker_state->stream, working_buffer, SAMPLE_BUFFER_SIZE*sizeof(int16_t));
@@ -226,3 +303,39 @@ void toggle_speaker_recording(cpu_state *cpu)
     }
 };
 
+/**
+ * Audio capture: the same samples that go to the audio device, written as a
+ * 44.1KHz 16-bit mono .wav. The header's sizes get filled in at power off.
+ */
+static void write_wav_header(FILE *fp, uint32_t samples) {
+    uint32_t data_bytes = samples * sizeof(int16_t);
+    uint8_t h[44] = { 'R','I','F','F', 0,0,0,0, 'W','A','V','E', 'f','m','t',' ', 16,0,0,0, 1,0, 1,0,
+                      0x44,0xAC,0,0, 0x88,0x58,0x01,0, 2,0, 16,0, 'd','a','t','a', 0,0,0,0 };
+    uint32_t riff_bytes = 36 + data_bytes;
+    for (int i = 0; i < 4; i++) {
+        h[4 + i] = (riff_bytes >> (i * 8)) & 0xFF;
+        h[40 + i] = (data_bytes >> (i * 8)) & 0xFF;
+    }
+    fwrite(h, 1, sizeof(h), fp);
+}
+
+void speaker_capture_open(speaker_state_t *speaker_state, const char *filename) {
+    speaker_state->capture = fopen(filename, "wb");
+    if (speaker_state->capture == nullptr) {
+        fprintf(stderr, "Could not open audio capture file %s\n", filename);
+        return;
+    }
+    speaker_state->capture_samples = 0;
+    write_wav_header(speaker_state->capture, 0);
+}
+
+void power_off_speaker(cpu_state *cpu, SlotType_t slot) {
+    speaker_state_t *speaker_state = (speaker_state_t *)get_module_state(cpu, MODULE_SPEAKER);
+
+    if (speaker_state->capture) {
+        fseek(speaker_state->capture, 0, SEEK_SET);
+        write_wav_header(speaker_state->capture, (uint32_t)speaker_state->capture_samples);
+        fclose(speaker_state->capture);
+        speaker_state->capture = nullptr;
+    }
+}
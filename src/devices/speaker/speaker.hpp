@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <SDL3/SDL.h>
+
 #include "cpu.hpp"
 
 #define SAMPLE_BUFFER_SIZE (4096)
@@ -67,7 +69,9 @@ typedef struct speaker_state_t {
     //cpu_state *cpu = NULL;
     FILE *speaker_recording = NULL;
     SDL_AudioDeviceID device_id = 0;
-    SDL_AudioStream *stream = NULL;
+    SDL_AudioStream *stream = NULL; // opened on the first speaker toggle, unless audio is off.
+    FILE *capture = NULL;
+    uint64_t capture_samples = 0;
     int device_started = 0;
     int polarity = 1;
     int16_t last_sample = 0;
@@ -82,4 +86,9 @@ void dump_partial_speaker_event_log(uint64_t cycles_now);
 void speaker_start(cpu_state *cpu);
 void speaker_stop();
 //void audio_generate_frame(cpu_state *cpu);
-void audio_generate_frame(cpu_state *cpu, uint64_t last_cycle_window_start, uint64_t cycle_window_start);
\ No newline at end of file
+void audio_generate_frame(cpu_state *cpu, uint64_t last_cycle_window_start, uint64_t cycle_window_start);
+void audio_discard_frame(cpu_state *cpu, uint64_t cycle_window_end);
+void audio_capture_frame(cpu_state *cpu, uint64_t cycle_window_start, uint64_t cycle_window_end);
+void speaker_capture_open(speaker_state_t *speaker_state, const char *filename);
+void power_off_speaker(cpu_state *cpu, SlotType_t slot);
+void speaker_synthesize(speaker_state_t *speaker_state, int16_t *out, uint64_t samples_count, uint64_t cycle_window_start, uint64_t cycle_window_end);
\ No newline at end of file
@@ -29,6 +29,7 @@
 #include "thunderclockplus.hpp"
 
 #include "util/ResourceFile.hpp"
+#include "util/wall_clock.hpp"
 
 /*
 
@@ -61,10 +62,11 @@ uint8_t thunderblock_interrupt_rate = HZ64;
 
 // Returns 40 bits of time data in Thunderclock Plus format
 // the LSB of our 40-bit register is the LSB of the seconds-units field.
-uint64_t get_thunderclock_time() {
-    time_t now = time(nullptr);
-    struct tm *tm = localtime(&now);
-    
+uint64_t get_thunderclock_time(cpu_state *cpu) {
+    struct tm now;
+    wall_clock_now(cpu, &now);
+    struct tm *tm = &now;
+
     // First collect nibbles in order
     uint8_t nibbles[10] = {
         (uint8_t)(tm->tm_mon + 1),    // month (1-12 binary)
@@ -106,7 +108,7 @@ void thunderclock_write_register(cpu_state *cpu, uint16_t address, uint8_t value
     if ((thunderclock_command_register & TCP_STB) && ((value & TCP_STB) == 0)) {
         // read the command register.
         if ((value & TCP_CMD) == TCP_CMD_READ_TIME) {
-            thunderclock_time_register = get_thunderclock_time();
+            thunderclock_time_register = get_thunderclock_time(cpu);
             fprintf(stderr, "Thunderclock Plus read time: %llX\n", thunderclock_time_register);
         }
     }
@@ -121,17 +123,6 @@ void thunderclock_write_register(cpu_state *cpu, uint16_t address, uint8_t value
 
 }
 
-void map_rom_thunderclock(cpu_state *cpu) {
-    thunderclock_state * thunderclock_d = (thunderclock_state *)get_module_state(cpu, MODULE_THUNDERCLOCK);
-    uint8_t *dp = thunderclock_d->rom->get_data();
-    for (uint8_t page = 0; page < 8; page++) {
-        memory_map_page_both(cpu, page + 0xC8, dp + (page * 0x100), MEM_IO);
-    }
-    if (DEBUG(DEBUG_THUNDERCLOCK)) {
-        printf("mapped in thunderclock $C800-$CFFF\n");
-    }
-}
-
 void init_slot_thunderclock(cpu_state *cpu, SlotType_t slot) {
     uint16_t thunderclock_cmd_reg = THUNDERCLOCK_CMD_REG_BASE + (slot << 4);
     fprintf(stderr, "Thunderclock Plus init at SLOT %d address %X\n", slot, thunderclock_cmd_reg);
@@ -159,5 +150,5 @@ void init_slot_thunderclock(cpu_state *cpu, SlotType_t slot) {
     register_C0xx_memory_read_handler(thunderclock_cmd_reg, thunderclock_read_register);
     register_C0xx_memory_write_handler(thunderclock_cmd_reg, thunderclock_write_register);
 
-    register_C8xx_handler(cpu, slot, map_rom_thunderclock);
+    register_C8xx_rom(cpu, slot, rom_data);
 }
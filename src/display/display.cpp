@@ -27,8 +27,13 @@
 #include "text_40x24.hpp"
 #include "lores_40x48.hpp"
 #include "hgr_280x192.hpp"
+#include "text_80x24.hpp"
+#include "lores_80x48.hpp"
+#include "hgr_560x192.hpp"
+#include "video_scanner.hpp"
 #include "platforms.hpp"
 #include "event_poll.hpp"
+#include "util/reset.hpp"
 
 
 display_page_t display_pages[NUM_DISPLAY_PAGES] = {
@@ -162,6 +167,43 @@ display_page_t display_pages[NUM_DISPLAY_PAGES] = {
 void set_display_page(cpu_state *cpu, display_page_number_t page) {
     display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
     ds->display_page_table = &display_pages[page];
+    update_video_observers(cpu);
+}
+
+/**
+ * Flag the pages of whatever is on screen right now, so memory_bus_write
+ * only calls the text / hgr write hooks for those. Everything else - the
+ * page that isn't shown, hires memory while in text mode - costs nothing.
+ * Has to be redone whenever the mode or page changes.
+ */
+void update_video_observers(cpu_state *cpu) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+    display_page_t *dp = ds->display_page_table;
+    uint8_t *observer = cpu->memory->video_observer;
+
+    bool text = false;
+    bool hgr = false;
+    for (int y = 0; y < 24; y++) {
+        switch (ds->line_mode[y]) {
+            case LM_HIRES_MODE:
+            case LM_DHIRES_MODE:
+                hgr = true;
+                break;
+            default:
+                text = true;
+                break;
+        }
+    }
+
+    memset(observer + 0x04, VIDEO_OBSERVER_NONE, 0x60 - 0x04);
+    if (text) {
+        memset(observer + dp->text_page_start / GS2_PAGE_SIZE, VIDEO_OBSERVER_TEXT,
+            (dp->text_page_end + 1 - dp->text_page_start) / GS2_PAGE_SIZE);
+    }
+    if (hgr) {
+        memset(observer + dp->hgr_page_start / GS2_PAGE_SIZE, VIDEO_OBSERVER_HGR,
+            (dp->hgr_page_end + 1 - dp->hgr_page_start) / GS2_PAGE_SIZE);
+    }
 }
 
 void set_display_page1(cpu_state *cpu) {
@@ -269,13 +311,21 @@ void update_display(cpu_state *cpu) {
     SDL_RenderClear(ds->renderer); 
 
     int updated = 0;
+    int first_line = 24, last_line = -1;
     for (int line = 0; line < 24; line++) {
         if (ds->dirty_line[line]) {
             render_line(cpu, line);
             ds->dirty_line[line] = 0;
             updated = 1;
+            if (line < first_line) first_line = line;
+            last_line = line;
         }
     }
+    if (updated) {
+        // one upload covering the dirty band.
+        SDL_Rect band = { 0, first_line * 8, BASE_WIDTH, (last_line - first_line + 1) * 8 };
+        SDL_UpdateTexture(ds->screenTexture, &band, ds->framebuffer + (first_line * 8 * BASE_WIDTH), FRAMEBUFFER_PITCH);
+    }
 
  /*    if (updated) { */
         SDL_FRect dstrect = {
@@ -290,6 +340,18 @@ void update_display(cpu_state *cpu) {
 /*     } */
 }
 
+/**
+ * Render every line into the framebuffer, dirty or not. No SDL - this is what
+ * headless runs use to get a finished frame.
+ */
+void render_frame(cpu_state *cpu) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+    for (int line = 0; line < 24; line++) {
+        render_line(cpu, line);
+        ds->dirty_line[line] = 0;
+    }
+}
+
 void force_display_update(cpu_state *cpu) {
     display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
     for (int y = 0; y < 24; y++) {
@@ -312,18 +374,22 @@ void update_line_mode(cpu_state *cpu) {
     line_mode_t top_mode;
     line_mode_t bottom_mode;
 
+    bool col80 = (ds->display_col_mode == COL80_MODE);
+    bool doubled = col80 && ds->display_dhires;
+    line_mode_t text_mode = col80 ? LM_TEXT80_MODE : LM_TEXT_MODE;
+
     if (ds->display_mode == TEXT_MODE) {
-        top_mode = LM_TEXT_MODE;
+        top_mode = text_mode;
     } else {
         if (ds->display_graphics_mode == LORES_MODE) {
-            top_mode = LM_LORES_MODE;
+            top_mode = doubled ? LM_DLORES_MODE : LM_LORES_MODE;
         } else {
-            top_mode = LM_HIRES_MODE;
+            top_mode = doubled ? LM_DHIRES_MODE : LM_HIRES_MODE;
         }
     }
 
     if (ds->display_split_mode == SPLIT_SCREEN) {
-        bottom_mode = LM_TEXT_MODE;
+        bottom_mode = text_mode;
     } else {
         bottom_mode = top_mode;
     }
@@ -334,6 +400,7 @@ void update_line_mode(cpu_state *cpu) {
     for (int y = 20; y < 24; y++) {
         ds->line_mode[y] = bottom_mode;
     }
+    update_video_observers(cpu);
 }
 
 void set_display_mode(cpu_state *cpu, display_mode_t mode) {
@@ -357,9 +424,25 @@ void set_graphics_mode(cpu_state *cpu, display_graphics_mode_t mode) {
     update_line_mode(cpu);
 }
 
-// TODO: this code can likely lock the whole screen, so we do one lock
-// (relatively expensive) instead of one lock per line.
+void set_col_mode(cpu_state *cpu, display_col_mode_t mode) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+
+    ds->display_col_mode = mode;
+    update_line_mode(cpu);
+}
+
+void set_dhires(cpu_state *cpu, bool dhires) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+
+    ds->display_dhires = dhires;
+    update_line_mode(cpu);
+}
 
+/**
+ * Render one text row (8 scanlines) into the software framebuffer. No SDL here -
+ * update_display uploads the whole framebuffer to the texture once per frame,
+ * instead of one texture lock per line.
+ */
 void render_line(cpu_state *cpu, int y) {
     display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
 
@@ -367,23 +450,9 @@ void render_line(cpu_state *cpu, int y) {
         return;
     }
 
-    // this writes into texture - do not put border stuff here.
-    SDL_Rect updateRect = {
-        0,          // X position (left of window))
-        y * 8,      // Y position (8 pixels per character)
-        BASE_WIDTH,        // Width of line
-        8           // Height of line
-    };
-
-    // the texture is our canvas. When we 'lock' it, we get a pointer to the pixels, and the pitch which is pixels per row
-    // of the area. Since all our chars are the same we can just use the same pitch for all our chars.
-
-    void* pixels;
-    int pitch;
-    if (!SDL_LockTexture(ds->screenTexture, &updateRect, &pixels, &pitch)) {
-        fprintf(stderr, "Failed to lock texture: %s\n", SDL_GetError());
-        return;
-    }
+    // do not put border stuff here.
+    void *pixels = ds->framebuffer + (y * 8 * BASE_WIDTH);
+    int pitch = FRAMEBUFFER_PITCH;
 
     line_mode_t mode = ds->line_mode[y];
     if (mode == LM_TEXT_MODE) {
@@ -393,9 +462,13 @@ void render_line(cpu_state *cpu, int y) {
     } else if (mode == LM_HIRES_MODE) {
         //render_hgr_scanline_mono(cpu, y, pixels, pitch);
         render_hgr_scanline(cpu, y, pixels, pitch);
+    } else if (mode == LM_TEXT80_MODE) {
+        render_text80_scanline(cpu, y, pixels, pitch);
+    } else if (mode == LM_DLORES_MODE) {
+        render_dlores_scanline(cpu, y, pixels, pitch);
+    } else if (mode == LM_DHIRES_MODE) {
+        render_dhgr_scanline(cpu, y, pixels, pitch);
     }
-
-    SDL_UnlockTexture(ds->screenTexture);
 }
 
 
@@ -506,6 +579,51 @@ void txt_bus_write_C057(cpu_state *cpu, uint16_t address, uint8_t value) {
 }
 
 
+/**
+ * IIe 80-column / double-res switches. See init_display_80col.
+ */
+void txt_bus_write_C00C(cpu_state *cpu, uint16_t address, uint8_t value) {
+    if (DEBUG(DEBUG_DISPLAY)) fprintf(stdout, "Set 40 Column Mode\n");
+    set_col_mode(cpu, COL40_MODE);
+    force_display_update(cpu);
+}
+
+void txt_bus_write_C00D(cpu_state *cpu, uint16_t address, uint8_t value) {
+    if (DEBUG(DEBUG_DISPLAY)) fprintf(stdout, "Set 80 Column Mode\n");
+    set_col_mode(cpu, COL80_MODE);
+    force_display_update(cpu);
+}
+
+uint8_t txt_bus_read_C01F(cpu_state *cpu, uint16_t address) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+    return (ds->display_col_mode == COL80_MODE) ? 0x80 : 0x00;
+}
+
+uint8_t txt_bus_read_C05E(cpu_state *cpu, uint16_t address) {
+    // AN3 off: double hi-res on
+    if (DEBUG(DEBUG_DISPLAY)) fprintf(stdout, "Set Double Hi-Res On\n");
+    set_dhires(cpu, true);
+    force_display_update(cpu);
+    return 0;
+}
+
+void txt_bus_write_C05E(cpu_state *cpu, uint16_t address, uint8_t value) {
+    txt_bus_read_C05E(cpu, address);
+}
+
+uint8_t txt_bus_read_C05F(cpu_state *cpu, uint16_t address) {
+    // AN3 on: double hi-res off
+    if (DEBUG(DEBUG_DISPLAY)) fprintf(stdout, "Set Double Hi-Res Off\n");
+    set_dhires(cpu, false);
+    force_display_update(cpu);
+    return 0;
+}
+
+void txt_bus_write_C05F(cpu_state *cpu, uint16_t address, uint8_t value) {
+    txt_bus_read_C05F(cpu, address);
+}
+
+
 void display_capture_mouse(cpu_state *cpu, bool capture) {
     display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
     SDL_SetWindowRelativeMouseMode(ds->window, capture);
@@ -523,9 +641,12 @@ display_state_t::display_state_t() {
     display_mode = TEXT_MODE;
     display_split_mode = FULL_SCREEN;
     display_graphics_mode = LORES_MODE;
+    display_col_mode = COL40_MODE;
+    display_dhires = false;
     window = nullptr;
     renderer = nullptr;
     screenTexture = nullptr;
+    framebuffer = new uint32_t[BASE_WIDTH * BASE_HEIGHT]();
     display_page_num = DISPLAY_PAGE_1;
     display_page_table = &display_pages[display_page_num];
     flash_state = false;
@@ -557,7 +678,37 @@ void init_mb_device_display(cpu_state *cpu, SlotType_t slot) {
     register_C0xx_memory_write_handler(0xC056, txt_bus_write_C056);
     register_C0xx_memory_write_handler(0xC057, txt_bus_write_C057);
 
-    init_display_sdl(ds);
+    update_line_mode(cpu);
+    init_video_scanner();
+    register_reset_handler(cpu, display_reset);
+
+    if (!gs2_app_values.headless) {
+        init_display_sdl(ds);
+    }
+}
+
+/**
+ * The video soft switches aren't touched by RESET (the ROM sets text mode
+ * itself), but what's mapped where may have changed under us - on a IIe the
+ * MMU switches just went off. Recompute and redraw everything.
+ */
+void display_reset(cpu_state *cpu) {
+    update_line_mode(cpu);
+    force_display_update(cpu);
+}
+
+/**
+ * Called by the IIe memory device once aux memory exists. On a II+ nothing
+ * calls this, and $C05E/$C05F stay plain annunciator 3.
+ */
+void init_display_80col(cpu_state *cpu) {
+    register_C0xx_memory_write_handler(0xC00C, txt_bus_write_C00C);
+    register_C0xx_memory_write_handler(0xC00D, txt_bus_write_C00D);
+    register_C0xx_memory_read_handler(0xC01F, txt_bus_read_C01F);
+    register_C0xx_memory_read_handler(0xC05E, txt_bus_read_C05E);
+    register_C0xx_memory_read_handler(0xC05F, txt_bus_read_C05F);
+    register_C0xx_memory_write_handler(0xC05E, txt_bus_write_C05E);
+    register_C0xx_memory_write_handler(0xC05F, txt_bus_write_C05F);
 }
 
 void set_display_color_mode(cpu_state *cpu, display_color_mode_t mode) {
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <SDL3/SDL.h>
+
 #include "gs2.hpp"
 #include "cpu.hpp"
 #include "platforms.hpp"
@@ -27,6 +29,7 @@
 #define BASE_HEIGHT 192
 #define BORDER_WIDTH 10
 #define BORDER_HEIGHT 10
+#define FRAMEBUFFER_PITCH (BASE_WIDTH * sizeof(uint32_t))
 
 // Graphics vs Text, C050 / C051
 typedef enum {
@@ -46,10 +49,19 @@ typedef enum {
     HIRES_MODE = 1,
 } display_graphics_mode_t;
 
+// 40 vs 80 columns, C00C / C00D (IIe, needs aux memory)
+typedef enum {
+    COL40_MODE = 0,
+    COL80_MODE = 1,
+} display_col_mode_t;
+
 typedef enum {
     LM_TEXT_MODE    = 0,
     LM_LORES_MODE   = 1,
-    LM_HIRES_MODE   = 2
+    LM_HIRES_MODE   = 2,
+    LM_TEXT80_MODE  = 3,
+    LM_DLORES_MODE  = 4,
+    LM_DHIRES_MODE  = 5
 } line_mode_t;
 
 typedef enum {
@@ -91,19 +103,22 @@ public:
     SDL_Window *window;
     SDL_Renderer* renderer ;
     SDL_Texture* screenTexture;
+    uint32_t *framebuffer; // BASE_WIDTH x BASE_HEIGHT, RGBA8888. render_line draws here; copied to screenTexture once per frame.
 
     display_fullscreen_mode_t display_fullscreen_mode;
     display_color_mode_t color_mode;
     display_mode_t display_mode;
     display_split_mode_t display_split_mode;
     display_graphics_mode_t display_graphics_mode;
+    display_col_mode_t display_col_mode;
+    bool display_dhires;   // C05E on / C05F off. With 80 columns on, lo-res and hi-res are doubled.
     display_page_number_t display_page_num;
     display_page_t *display_page_table;
     bool flash_state;
     int flash_counter;
 
     uint32_t dirty_line[24];
-    line_mode_t line_mode[24]; // 0 = TEXT, 1 = LO RES GRAPHICS, 2 = HI RES GRAPHICS
+    line_mode_t line_mode[24]; // 0 = TEXT, 1 = LO RES GRAPHICS, 2 = HI RES GRAPHICS, 3-5 = the 80-column / double versions
 
 } display_state_t;
 
@@ -119,16 +134,23 @@ void free_display(cpu_state *cpu);
 void txt_memory_write(uint16_t , uint8_t );
 void update_flash_state(cpu_state *cpu);
 void init_mb_device_display(cpu_state *cpu, SlotType_t slot);
+void display_reset(cpu_state *cpu);
+void init_display_80col(cpu_state *cpu);
+void set_display_page(cpu_state *cpu, display_page_number_t page);
 void render_line(cpu_state *cpu, int y);
+void render_frame(cpu_state *cpu);
 void pre_calculate_font(rom_data *rd);
 void init_display_font(rom_data *rd);
 void set_display_color_mode(cpu_state *cpu, display_color_mode_t mode);
 void toggle_display_color_mode(cpu_state *cpu);
 void toggle_display_fullscreen(cpu_state *cpu);
 void update_line_mode(cpu_state *cpu);
+void update_video_observers(cpu_state *cpu);
 void set_display_mode(cpu_state *cpu, display_mode_t mode);
 void set_split_mode(cpu_state *cpu, display_split_mode_t mode);
 void set_graphics_mode(cpu_state *cpu, display_graphics_mode_t mode);
+void set_col_mode(cpu_state *cpu, display_col_mode_t mode);
+void set_dhires(cpu_state *cpu, bool dhires);
 void display_capture_mouse(cpu_state *cpu, bool capture);
 void display_dump_hires_page(cpu_state *cpu, int page);
 void display_dump_text_page(cpu_state *cpu, int page);
@@ -59,7 +59,7 @@ void render_hgr_scanline_mono(cpu_state *cpu, int y, void *pixels, int pitch) {
             int charoff = x * 14;
 
             uint16_t address = HGR_PAGE_TABLE[y] + (row * 0x0400) + x;
-            uint8_t character = raw_memory_read(cpu, address);
+            uint8_t character = cpu->main_ram_64[address];
             uint8_t ch_D7 = character & 0x80;
 
             uint32_t base = row * pitchoff;
@@ -119,7 +119,7 @@ void render_hgr_scanline_color(cpu_state *cpu, int y, void *pixels, int pitch) {
             int charoff = x * 14;
 
             uint16_t address = HGR_PAGE_TABLE[y] + (row * 0x0400) + x;
-            uint8_t character = raw_memory_read(cpu, address);
+            uint8_t character = cpu->main_ram_64[address];
             uint8_t ch_D7 = (character & 0x80) >> 7;
 
             uint32_t base = row * pitchoff;
@@ -172,10 +172,7 @@ void hgr_memory_write(cpu_state *cpu, uint16_t address, uint8_t value) {
     uint16_t HGR_PAGE_START = display_page->hgr_page_start;
     uint16_t HGR_PAGE_END = display_page->hgr_page_end;
 
-    // Skip unless we're in graphics mode.
-    if (! (ds->display_mode == GRAPHICS_MODE && ds->display_graphics_mode == HIRES_MODE)) {
-        return;
-    }
+    // only called for the shown hires page while hires is up - see update_video_observers.
     if (DEBUG(DEBUG_HGR)) fprintf(stdout, "hgr_memory_write address: %04X value: %02X\n", address, value);
     // Strict bounds checking for text page 1
     if (address < HGR_PAGE_START || address > HGR_PAGE_END) {
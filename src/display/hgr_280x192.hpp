@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include "cpu.hpp"
 
+extern uint32_t hgr_mono_table[];
+
 void hgr_memory_write(cpu_state *cpu, uint16_t address, uint8_t value);
 void render_hgr_scanline_mono(cpu_state *cpu, int y, void *pixels, int pitch);
 void render_hgr_scanline_color(cpu_state *cpu, int y, void *pixels, int pitch);
@@ -0,0 +1,123 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gs2.hpp"
+#include "cpu.hpp"
+#include "memory.hpp"
+#include "display.hpp"
+#include "hgr_280x192.hpp"
+#include "hgr_560x192.hpp"
+
+/**
+ * Double hi-res. Each of the 40 byte columns is an aux byte followed by a
+ * main byte, 7 dots from each (D7 is ignored), LSB first: 560 dots a line.
+ *
+ * Color is 4 dots per color cycle. Rather than chop the line into 140 fixed
+ * 4-dot cells, each dot takes its color from the last 4 dots seen (a sliding
+ * window), which is closer to what a composite monitor does: color edges
+ * land where the bits change, not on cell boundaries.
+ *
+ * The window holds dots p-3..p with the oldest in bit 0. Which bit of the
+ * color number each dot is depends on its position mod 4, so the window is
+ * rotated into color-number order by phase. Both steps are folded into
+ * dhgr_color_lut[phase][window], built once from the lo-res palette (the
+ * 16 DHGR colors are the 16 lo-res colors).
+ */
+static const uint8_t dhgr_window_color[4][16] = {
+    { 0x0, 0x2, 0x4, 0x6, 0x8, 0xA, 0xC, 0xE, 0x1, 0x3, 0x5, 0x7, 0x9, 0xB, 0xD, 0xF },
+    { 0x0, 0x4, 0x8, 0xC, 0x1, 0x5, 0x9, 0xD, 0x2, 0x6, 0xA, 0xE, 0x3, 0x7, 0xB, 0xF },
+    { 0x0, 0x8, 0x1, 0x9, 0x2, 0xA, 0x3, 0xB, 0x4, 0xC, 0x5, 0xD, 0x6, 0xE, 0x7, 0xF },
+    { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF },
+};
+
+static uint32_t dhgr_color_lut[4][16];
+static bool dhgr_color_lut_ready = false;
+
+static void build_dhgr_color_lut() {
+    for (int phase = 0; phase < 4; phase++) {
+        for (int window = 0; window < 16; window++) {
+            dhgr_color_lut[phase][window] = lores_color_table[dhgr_window_color[phase][window]];
+        }
+    }
+    dhgr_color_lut_ready = true;
+}
+
+void render_dhgr_scanline_color(cpu_state *cpu, int y, void *pixels, int pitch) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+    uint16_t *HGR_PAGE_TABLE = ds->display_page_table->hgr_page_table;
+
+    if (!dhgr_color_lut_ready) {
+        build_dhgr_color_lut();
+    }
+
+    int pitchoff = pitch / 4;
+    uint32_t* texturePixels = (uint32_t*)pixels;
+
+    for (int row = 0; row < 8; row++) {
+        uint16_t address = HGR_PAGE_TABLE[y] + (row * 0x0400);
+        const uint8_t *main_line = cpu->main_ram_64 + address;
+        const uint8_t *aux_line = cpu->aux_ram_64 + address;
+        uint32_t *out = texturePixels + row * pitchoff;
+
+        uint32_t window = 0; // black to the left of the screen.
+        for (int x = 0; x < 40; x++) {
+            // 14 dots, aux first. Column x starts at dot 14x, so phase 0 or 2.
+            uint32_t dots = (aux_line[x] & 0x7F) | ((main_line[x] & 0x7F) << 7);
+            int phase = (x & 1) << 1;
+            for (int bit = 0; bit < 14; bit++) {
+                window = (window >> 1) | ((dots & 1) << 3);
+                *out++ = dhgr_color_lut[phase][window];
+                phase = (phase + 1) & 3;
+                dots >>= 1;
+            }
+        }
+    }
+}
+
+void render_dhgr_scanline_mono(cpu_state *cpu, int y, void *pixels, int pitch) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+    uint16_t *HGR_PAGE_TABLE = ds->display_page_table->hgr_page_table;
+    uint32_t mono_lut[2] = { 0x00000000, hgr_mono_table[ds->color_mode] };
+
+    int pitchoff = pitch / 4;
+    uint32_t* texturePixels = (uint32_t*)pixels;
+
+    for (int row = 0; row < 8; row++) {
+        uint16_t address = HGR_PAGE_TABLE[y] + (row * 0x0400);
+        const uint8_t *main_line = cpu->main_ram_64 + address;
+        const uint8_t *aux_line = cpu->aux_ram_64 + address;
+        uint32_t *out = texturePixels + row * pitchoff;
+
+        for (int x = 0; x < 40; x++) {
+            uint32_t dots = (aux_line[x] & 0x7F) | ((main_line[x] & 0x7F) << 7);
+            for (int bit = 0; bit < 14; bit++) {
+                *out++ = mono_lut[dots & 1];
+                dots >>= 1;
+            }
+        }
+    }
+}
+
+void render_dhgr_scanline(cpu_state *cpu, int y, void *pixels, int pitch) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+
+    if (ds->color_mode != DM_COLOR_MODE) {
+        render_dhgr_scanline_mono(cpu, y, pixels, pitch);
+    } else {
+        render_dhgr_scanline_color(cpu, y, pixels, pitch);
+    }
+}
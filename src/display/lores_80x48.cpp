@@ -0,0 +1,78 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gs2.hpp"
+#include "cpu.hpp"
+#include "memory.hpp"
+#include "display.hpp"
+#include "lores_40x48.hpp"
+#include "lores_80x48.hpp"
+
+/**
+ * Double lo-res: 80x48 blocks, each 7 pixels wide. Like 80-column text, the
+ * aux byte is the left block of each pair and the main byte the right one.
+ *
+ * An aux block lands a quarter color-cycle off from where a main block would,
+ * so the same nibble in aux shows a different color: the one you get by
+ * rotating the 4 bits left by one. Programs store the nibble pre-rotated the
+ * other way; we just undo it with a lookup.
+ */
+static const uint8_t dlores_aux_color[16] = {
+    0x0, 0x2, 0x4, 0x6, 0x8, 0xA, 0xC, 0xE,
+    0x1, 0x3, 0x5, 0x7, 0x9, 0xB, 0xD, 0xF,
+};
+
+static inline void render_dlores_block(uint32_t *texturePixels, int pitchoff, int charoff, uint32_t color_top, uint32_t color_bottom) {
+    for (int row = 0; row < 8; row++) {
+        uint32_t color = (row < 4) ? color_top : color_bottom;
+        uint32_t *out = texturePixels + row * pitchoff + charoff;
+        out[0] = color;
+        out[1] = color;
+        out[2] = color;
+        out[3] = color;
+        out[4] = color;
+        out[5] = color;
+        out[6] = color;
+    }
+}
+
+void render_dlores_scanline(cpu_state *cpu, int y, void *pixels, int pitch) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+    uint16_t *TEXT_PAGE_TABLE = ds->display_page_table->text_page_table;
+
+    // Bounds checking
+    if (y < 0 || y >= 24) {
+        return;
+    }
+
+    int pitchoff = pitch / 4;
+    uint32_t* texturePixels = (uint32_t*)pixels;
+    const uint8_t *main_line = cpu->main_ram_64 + TEXT_PAGE_TABLE[y];
+    const uint8_t *aux_line = cpu->aux_ram_64 + TEXT_PAGE_TABLE[y];
+
+    for (int x = 0; x < 40; x++) {
+        uint8_t aux = aux_line[x];
+        uint8_t main = main_line[x];
+
+        render_dlores_block(texturePixels, pitchoff, x * 14,
+            lores_color_table[dlores_aux_color[aux & 0x0F]],
+            lores_color_table[dlores_aux_color[aux >> 4]]);
+        render_dlores_block(texturePixels, pitchoff, x * 14 + 7,
+            lores_color_table[main & 0x0F],
+            lores_color_table[main >> 4]);
+    }
+}
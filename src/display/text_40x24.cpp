@@ -91,7 +91,8 @@ void render_text_scanline(cpu_state *cpu, int y, void *pixels, int pitch) {
 
     for (int x = 0; x < 40; x++) {
 
-        uint8_t character = raw_memory_read(cpu, TEXT_PAGE_TABLE[y] + x);
+        // video always fetches from main RAM, whatever RAMRD / 80STORE have mapped in.
+        uint8_t character = cpu->main_ram_64[TEXT_PAGE_TABLE[y] + x];
 
         // Calculate font offset (8 bytes per character, starting at 0x20)
         const uint32_t* charPixels = &APPLE2_FONT_32[character * 56];
@@ -155,16 +156,21 @@ void update_flash_state(cpu_state *cpu) {
     }
     ds->flash_counter = 0;
     ds->flash_state = !ds->flash_state;
+    bool col80 = (ds->display_col_mode == COL80_MODE);
 
     for (int y = 0; y < 24; y++) {
         // TODO: can change this to grab 64 bits at a time and check for flash chars by & 0xC0C0C0C0C0C0C0C0 and comparing to 0x4040... 
         for (int x = 0; x < 40; x++) {
             uint16_t addr = TEXT_PAGE_TABLE[y] + x;
-            uint8_t character = raw_memory_read(cpu, addr);
+            uint8_t character = cpu->main_ram_64[addr];
             if ((character & 0b11000000) == 0x40) {
                 ds->dirty_line[y] = 1;
                 break;                           // stop after we find any flash char on a line.
             }
+            if (col80 && (cpu->aux_ram_64[addr] & 0b11000000) == 0x40) {
+                ds->dirty_line[y] = 1;
+                break;
+            }
         }
     }
 }
@@ -19,6 +19,9 @@
 
 #include "cpu.hpp"
 
+extern uint32_t APPLE2_FONT_32[];
+extern uint32_t text_color_table[];
+
 void txt_memory_write(cpu_state *, uint16_t , uint8_t );
 void update_flash_state(cpu_state *cpu);
 void render_text_scanline(cpu_state *cpu, int y, void *pixels, int pitch);
@@ -0,0 +1,74 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gs2.hpp"
+#include "cpu.hpp"
+#include "memory.hpp"
+#include "display.hpp"
+#include "text_40x24.hpp"
+#include "text_80x24.hpp"
+
+/**
+ * 80-column text. Each of the 40 text addresses holds two characters: the
+ * aux memory byte is displayed first, then the main memory byte, each 7
+ * pixels wide (no doubling, unlike 40 columns).
+ * The video hardware always fetches from main and aux RAM directly, whatever
+ * the CPU's RAMRD/80STORE banking is, and so do we.
+ */
+static inline void render_80col_char(uint32_t *texturePixels, int pitchoff, int charoff, uint8_t character, bool flash_state, uint32_t color_value) {
+    const uint32_t* charPixels = &APPLE2_FONT_32[character * 56];
+
+    uint32_t xor_mask = 0x00000000;
+    if ((character & 0xC0) == 0) {
+        xor_mask = 0xFFFFFFFF;
+    } else if ((character & 0xC0) == 0x40 && flash_state) {
+        xor_mask = 0xFFFFFFFF;
+    }
+
+    for (int row = 0; row < 8; row++) {
+        uint32_t *out = texturePixels + row * pitchoff + charoff;
+        out[0] = (charPixels[0] ^ xor_mask) & color_value;
+        out[1] = (charPixels[1] ^ xor_mask) & color_value;
+        out[2] = (charPixels[2] ^ xor_mask) & color_value;
+        out[3] = (charPixels[3] ^ xor_mask) & color_value;
+        out[4] = (charPixels[4] ^ xor_mask) & color_value;
+        out[5] = (charPixels[5] ^ xor_mask) & color_value;
+        out[6] = (charPixels[6] ^ xor_mask) & color_value;
+        charPixels += 7;
+    }
+}
+
+void render_text80_scanline(cpu_state *cpu, int y, void *pixels, int pitch) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+    uint32_t color_value = text_color_table[ds->color_mode];
+    uint16_t *TEXT_PAGE_TABLE = ds->display_page_table->text_page_table;
+
+    // Bounds checking
+    if (y < 0 || y >= 24) {
+        return;
+    }
+
+    int pitchoff = pitch / 4;
+    uint32_t* texturePixels = (uint32_t*)pixels;
+    const uint8_t *main_line = cpu->main_ram_64 + TEXT_PAGE_TABLE[y];
+    const uint8_t *aux_line = cpu->aux_ram_64 + TEXT_PAGE_TABLE[y];
+
+    for (int x = 0; x < 40; x++) {
+        render_80col_char(texturePixels, pitchoff, x * 14, aux_line[x], ds->flash_state, color_value);
+        render_80col_char(texturePixels, pitchoff, x * 14 + 7, main_line[x], ds->flash_state, color_value);
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "cpu.hpp"
+#include "display/display.hpp"
+#include "display/video_scanner.hpp"
+
+/**
+ * Scanner address at each cycle of the frame, without the page bits (those
+ * depend on soft switches and get added at read time). Position 0 is H=$00
+ * on the first visible line, the start of its horizontal blank.
+ *  text: a0-a9, plus $1000 during horizontal blanking - on the II and II+
+ *        the text address picks up A12 there (UTAIIe I-4 #5). The IIe
+ *        doesn't do that; we don't tell them apart yet.
+ *  hires: a0-a12.
+ * mixed_text: lines that show text in a mixed hires screen (V4 and V2).
+ */
+static uint16_t scanner_text[SCANNER_CYCLES_PER_FRAME];
+static uint16_t scanner_hires[SCANNER_CYCLES_PER_FRAME];
+static bool scanner_mixed_text[SCANNER_LINES];
+static bool scanner_ready = false;
+
+void init_video_scanner() {
+    if (scanner_ready) {
+        return;
+    }
+    for (int line = 0; line < SCANNER_LINES; line++) {
+        // V counts $100-$1FF, then $FA-$FF through vertical blank.
+        int v = 0x100 + line;
+        if (line >= 256) {
+            v -= SCANNER_LINES;
+        }
+        int va = (v >> 0) & 1, vb = (v >> 1) & 1, vc = (v >> 2) & 1;
+        int v0 = (v >> 3) & 1, v1 = (v >> 4) & 1, v2 = (v >> 5) & 1;
+        int v3 = (v >> 6) & 1, v4 = (v >> 7) & 1;
+
+        scanner_mixed_text[line] = v4 && v2;
+
+        /* Each row starts where V ticks over: H wraps from $7F to $00, stays
+           there one cycle, then counts $40-$7F. So all of horizontal blank
+           ($00, $40-$57) carries this line's V, and display is $58-$7F, 25
+           cycles in. */
+        for (int cycle = 0; cycle < SCANNER_CYCLES_PER_LINE; cycle++) {
+            int h = (cycle == 0) ? 0x00 : 0x3F + cycle;
+            int h0 = (h >> 0) & 1, h1 = (h >> 1) & 1, h2 = (h >> 2) & 1;
+            int h3 = (h >> 3) & 1, h4 = (h >> 4) & 1, h5 = (h >> 5) & 1;
+
+            int sum = (0x0D + ((h5 << 2) | (h4 << 1) | h3) + ((v4 << 3) | (v3 << 2) | (v4 << 1) | v3)) & 0x0F;
+            uint16_t address = h0 | (h1 << 1) | (h2 << 2) | (sum << 3) | (v0 << 7) | (v1 << 8) | (v2 << 9);
+
+            bool hbl = !h5 && (!h4 || !h3);
+            int pos = line * SCANNER_CYCLES_PER_LINE + cycle;
+            scanner_text[pos] = address | (hbl ? 0x1000 : 0);
+            scanner_hires[pos] = address | (va << 10) | (vb << 11) | (vc << 12);
+        }
+    }
+    scanner_ready = true;
+}
+
+uint16_t video_scanner_address(cpu_state *cpu) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+    uint32_t pos = cpu->cycles % SCANNER_CYCLES_PER_FRAME;
+    bool page2 = (ds->display_page_num == DISPLAY_PAGE_2);
+
+    bool hires = (ds->display_mode == GRAPHICS_MODE) && (ds->display_graphics_mode == HIRES_MODE);
+    if (hires && ds->display_split_mode == SPLIT_SCREEN && scanner_mixed_text[pos / SCANNER_CYCLES_PER_LINE]) {
+        hires = false;
+    }
+    if (hires) {
+        return scanner_hires[pos] + (page2 ? 0x4000 : 0x2000);
+    }
+    return scanner_text[pos] + (page2 ? 0x0800 : 0x0400);
+}
+
+/* what the video fetched this cycle. The scanner always reads main RAM. */
+uint8_t floating_bus_read(cpu_state *cpu) {
+    return cpu->main_ram_64[video_scanner_address(cpu)];
+}
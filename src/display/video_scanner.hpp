@@ -0,0 +1,40 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "cpu.hpp"
+
+/**
+ * Where the video scanner is. The Apple II video circuitry reads memory on
+ * the half of the cycle the CPU doesn't use, so whatever it fetched is still
+ * on the data bus when the CPU reads something nothing drives - the
+ * "floating bus". Vapor-lock style code reads it to sync to the beam.
+ *
+ * A frame is 262 lines of 65 cycles. The scanner address for every one of
+ * those 17030 positions is worked out once (Understanding the Apple IIe,
+ * ch. 5), so a read is a table lookup plus one memory read.
+ */
+
+#define SCANNER_CYCLES_PER_LINE 65
+#define SCANNER_LINES 262
+#define SCANNER_CYCLES_PER_FRAME (SCANNER_CYCLES_PER_LINE * SCANNER_LINES)
+
+void init_video_scanner();
+uint16_t video_scanner_address(cpu_state *cpu);
+uint8_t floating_bus_read(cpu_state *cpu);
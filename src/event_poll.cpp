@@ -23,9 +23,11 @@
 #include "display/display.hpp"
 #include "devices/game/mousewheel.hpp"
 #include "devices/game/gamecontroller.hpp"
+#include "devices/mouse/mouse.hpp"
 #include "devices/speaker/speaker.hpp"
 #include "devices/loader.hpp"
 #include "util/reset.hpp"
+#include "util/mount.hpp"
 
 // Base dimensions for aspect ratio calculation
 #define WIN_BASE_WIDTH 560
@@ -105,6 +107,14 @@ bool handle_sdl_keydown(cpu_state *cpu, SDL_Event event) {
             return true;
         }
     }
+    if (key == SDLK_F5) {
+        // next disk in the first (shift: second) drive that has a playlist
+        uint64_t playlist_key = cpu->mounts->playlist_key((mod & SDL_KMOD_SHIFT) ? 1 : 0);
+        if (playlist_key) {
+            cpu->mounts->swap_next(playlist_key);
+        }
+        return true;
+    }
     if (key == SDLK_F3) {
         toggle_display_fullscreen(cpu);
         return true;
@@ -147,6 +157,15 @@ void event_poll(cpu_state *cpu, SDL_Event &event) {
         case SDL_EVENT_MOUSE_BUTTON_DOWN:
             display_capture_mouse(cpu, true);
             //SDL_SetWindowRelativeMouseMode(cpu->window, true);
+            if (event.button.button == SDL_BUTTON_LEFT) mouse_button(cpu, true);
+            break;
+
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            if (event.button.button == SDL_BUTTON_LEFT) mouse_button(cpu, false);
+            break;
+
+        case SDL_EVENT_MOUSE_MOTION:
+            mouse_motion(cpu, event.motion.xrel, event.motion.yrel);
             break;
 
         case SDL_EVENT_MOUSE_WHEEL:
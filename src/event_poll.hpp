@@ -15,6 +15,8 @@
  *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <SDL3/SDL.h>
+
 #include "cpu.hpp"
 
 void event_poll(cpu_state *cpu, SDL_Event &event);
\ No newline at end of file
@@ -21,8 +21,10 @@
 #include <sstream>
 #include <iomanip>
 #include <time.h>
+#include <algorithm>
 /* #include <mach/mach_time.h> */
 #include <getopt.h>
+#include <SDL3_image/SDL_image.h>
 
 #include "gs2.hpp"
 #include "cpu.hpp"
@@ -37,6 +39,8 @@
 #include "devices/speaker/speaker.hpp"
 #include "devices/loader.hpp"
 #include "devices/prodos_block/prodos_block.hpp"
+#include "devices/memoryexpansion/memexp.hpp"
+#include "devices/mouse/mouse.hpp"
 #include "platforms.hpp"
 #include "util/media.hpp"
 #include "util/dialog.hpp"
@@ -111,6 +115,10 @@ void init_default_memory_map(cpu_state *cpu) {
         cpu->memory->pages_read[i + 0xC0] = cpu->main_io_4 + i * GS2_PAGE_SIZE;
         cpu->memory->pages_write[i + 0xC0] = cpu->main_io_4 + i * GS2_PAGE_SIZE;
     }
+    for (int i = 0; i < 8; i++) {
+        cpu->C8xx_idle_pages[i] = cpu->main_io_4 + (i + 0x08) * GS2_PAGE_SIZE;
+    }
+    cpu->C8xx_slot = 0xFF;
     for (int i = 0; i < (ROM_KB / GS2_PAGE_SIZE); i++) {
         cpu->memory->page_info[i + 0xD0].type = MEM_ROM;
         cpu->memory->page_info[i + 0xD0].can_read = 1;
@@ -118,11 +126,12 @@ void init_default_memory_map(cpu_state *cpu) {
         cpu->memory->pages_read[i + 0xD0] = cpu->main_rom_D0 + i * GS2_PAGE_SIZE;
         cpu->memory->pages_write[i + 0xD0] = cpu->main_rom_D0 + i * GS2_PAGE_SIZE;
     }
+    save_reset_memory_map(cpu);
 }
 void init_memory(cpu_state *cpu) {
     cpu->memory = new memory_map();
     
-    cpu->main_ram_64 = new uint8_t[RAM_KB];
+    cpu->main_ram_64 = new uint8_t[RAM_KB](); // zeroed, so a headless run is repeatable.
     cpu->main_io_4 = new uint8_t[IO_KB];
     cpu->main_rom_D0 = new uint8_t[ROM_KB];
 
@@ -179,6 +188,36 @@ void set_cpu_processor(cpu_state *cpu, int processor_type) {
 #define INSTRUMENT(x) 
 #endif
 
+/**
+ * Scripted disk swaps (-S cycles:sXdY[:eject]) so multi-disk titles can run
+ * headless. Each one fires at the first frame boundary at or after its cycle
+ * count: swap moves the drive to the next image in its playlist, eject empties it.
+ */
+struct disk_swap_t {
+    uint64_t cycle;
+    uint64_t key;
+    bool eject;
+};
+std::vector<disk_swap_t> disk_swaps;
+size_t next_disk_swap = 0;
+
+/* wait: block until the swap has actually happened, so headless runs come out the same every time. */
+void apply_disk_swaps(cpu_state *cpu, bool wait) {
+    bool swapped = false;
+    while (next_disk_swap < disk_swaps.size() && disk_swaps[next_disk_swap].cycle <= cpu->cycles) {
+        disk_swap_t &swap = disk_swaps[next_disk_swap++];
+        if (swap.eject) {
+            cpu->mounts->eject(swap.key);
+        } else if (!cpu->mounts->swap_next(swap.key)) {
+            fprintf(stderr, "No playlist for slot %d drive %d to swap\n", (int)(swap.key >> 8), (int)(swap.key & 0xFF) + 1);
+        }
+        swapped = true;
+    }
+    if (swapped && wait) {
+        cpu->mounts->flush_requests();
+    }
+}
+
 void run_cpus(void) {
     cpu_state *cpu = &CPUs[0];
 
@@ -195,6 +234,7 @@ void run_cpus(void) {
 
     uint64_t last_time_window_start = 0;
     uint64_t last_cycle_window_start = 0;
+    uint64_t free_run_frames = 0;
 
 
     while (1) {
@@ -230,14 +270,33 @@ void run_cpus(void) {
             cpu->cycles += cycles_for_this_burst;
         }
 
-        uint64_t current_time;
-        uint64_t audio_time;
-        uint64_t display_time;
-        uint64_t event_time;
+        apply_disk_swaps(cpu, false);
+        cpu->mounts->process_requests(); // disks swapped from the UI - prepared off-thread, this is just the swap.
+
+        uint64_t current_time = SDL_GetTicksNS();
+        uint64_t audio_time = 0;
+        uint64_t display_time = 0;
+        uint64_t event_time = 0;
+
+        /**
+         * Free run: the CPU runs as fast as it can, so an emulated frame takes far
+         * less than 1/60th second of host time. Don't present every one - either
+         * every Nth emulated frame (-F N), or by default at most once per host
+         * refresh. Dirty lines stay set across the skipped frames, so the frame
+         * we do draw picks up everything written in between.
+         */
+        bool free_run = (cpu->clock_mode == CLOCK_FREE_RUN);
+        bool frame_due = true;
+        if (free_run) {
+            free_run_frames++;
+            if (gs2_app_values.frame_skip > 0) {
+                frame_due = (free_run_frames % gs2_app_values.frame_skip) == 0;
+            } else {
+                frame_due = (current_time - last_display_update > 16667000);
+            }
+        }
 
-        if ((cpu->clock_mode == CLOCK_FREE_RUN) && (current_time - last_event_update > 16667000)
-            || (cpu->clock_mode != CLOCK_FREE_RUN)) {
-            current_time = SDL_GetTicksNS();
+        if (!free_run || (current_time - last_event_update > 16667000)) {
             SDL_Event event;
             while(SDL_PollEvent(&event)) {
                 if (!osd->event(event)) { // if osd doesn't handle it..
@@ -252,24 +311,30 @@ void run_cpus(void) {
         }
 
         /* Emit Audio Frame */
+        /* in free run a 1/60th second audio frame would cover many emulated frames of
+           toggles - there's no sensible pitch for that, so the speaker is muted.
+           A -w capture still gets every emulated frame. */
         current_time = SDL_GetTicksNS();
-        if ((cpu->clock_mode == CLOCK_FREE_RUN) && (current_time - last_audio_update > 16667000)
-            || (cpu->clock_mode != CLOCK_FREE_RUN)) {            
+        if (free_run) {
+            audio_capture_frame(cpu, last_cycle_window_start, cycle_window_start);
+        } else {
             audio_generate_frame(cpu, last_cycle_window_start, cycle_window_start);
             audio_time = SDL_GetTicksNS() - current_time;
             last_audio_update = current_time;
         }
 
+        /* flash and the mouse card's VBL run on emulated frames, whether or not this one gets presented. */
+        update_flash_state(cpu);
+        mouse_frame(cpu);
+
         /* Emit Video Frame */
         current_time = SDL_GetTicksNS();
-        if ((cpu->clock_mode == CLOCK_FREE_RUN) && (current_time - last_display_update > 16667000)
-            || (cpu->clock_mode != CLOCK_FREE_RUN)) {
+        if (frame_due) {
             /* SDL_Event event; // is this right??? Don't think this belongs here.. we already did above..
             while(SDL_PollEvent(&event)) {
                 event_poll(cpu, event); // they say call "once per frame"
             } */
             //event_poll(cpu); // they say call "once per frame"
-            update_flash_state(cpu);
             update_display(cpu);    
             osd->render();
             display_state_t *ds = (display_state_t *)get_module_state(&CPUs[0], MODULE_DISPLAY);
@@ -322,32 +387,150 @@ void run_cpus(void) {
 }
 
 
+/**
+ * Headless golden-image runs, for checking the renderers bit-for-bit in CI.
+ * Run for golden_cycles with no window or audio, render the final frame into
+ * the software framebuffer and hash it. If we were given the expected hash,
+ * compare, and on a mismatch write the frame out as a PNG to look at.
+ */
+uint64_t golden_cycles = 0;
+uint64_t golden_hash = 0;
+bool golden_hash_set = false;
+const char *golden_png = "golden_mismatch.png";
+
+/**
+ * -I: once golden_cycles is up, keep going until every drive has stopped (the
+ * Disk II motor's one-second run-down included), so the hash is taken after
+ * the boot or load has settled. Gives up after GOLDEN_IDLE_LIMIT more cycles.
+ */
+bool golden_wait_idle = false;
+#define GOLDEN_IDLE_LIMIT (60 * 1020500ULL)
+
+/* FNV-1a over the pixel values, byte order fixed so the hash is the same on any host. */
+uint64_t framebuffer_hash(display_state_t *ds) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < BASE_WIDTH * BASE_HEIGHT; i++) {
+        uint32_t pixel = ds->framebuffer[i];
+        for (int shift = 0; shift < 32; shift += 8) {
+            hash ^= (pixel >> shift) & 0xFF;
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+int run_golden(cpu_state *cpu) {
+    display_state_t *ds = (display_state_t *)get_module_state(cpu, MODULE_DISPLAY);
+    uint64_t frame_cycles = clock_mode_info[CLOCK_1_024MHZ].cycles_per_burst;
+
+    DriveEventQueue *drive_events = golden_wait_idle ? cpu->mounts->subscribe() : nullptr;
+    DriveStatusTracker *drives = drive_events ? new DriveStatusTracker(drive_events) : nullptr;
+
+    while (!cpu->halt) {
+        if (drives) {
+            drives->update(cpu->cycles); // drain every frame, so the queue never fills
+        }
+        if (cpu->cycles >= golden_cycles) {
+            if (!drives || drives->idle()) {
+                break;
+            }
+            if (cpu->cycles >= golden_cycles + GOLDEN_IDLE_LIMIT) {
+                printf("golden: drives still busy after %llu more cycles, stopping anyway\n", GOLDEN_IDLE_LIMIT);
+                break;
+            }
+        }
+        uint64_t frame_start = cpu->cycles;
+        uint64_t frame_end = cpu->cycles + frame_cycles;
+        while (cpu->cycles < frame_end) {
+            (cpu->execute_next)(cpu);
+        }
+        audio_generate_frame(cpu, frame_start, cpu->cycles); // only does real work if capturing (-w).
+        update_flash_state(cpu);
+        mouse_frame(cpu);
+        apply_disk_swaps(cpu, true);
+        cpu->mounts->process_requests();
+    }
+    if (drives) {
+        cpu->mounts->unsubscribe(drive_events);
+        delete drives;
+    }
+    render_frame(cpu);
+
+    uint64_t hash = framebuffer_hash(ds);
+    printf("framebuffer hash: %016llx after %llu cycles\n", hash, cpu->cycles);
+    if (!golden_hash_set) {
+        return 0;
+    }
+    if (hash == golden_hash) {
+        printf("golden: match\n");
+        return 0;
+    }
+    printf("golden: MISMATCH, expected %016llx\n", golden_hash);
+
+    SDL_Surface *surface = SDL_CreateSurfaceFrom(BASE_WIDTH, BASE_HEIGHT, SDL_PIXELFORMAT_RGBA8888, ds->framebuffer, FRAMEBUFFER_PITCH);
+    if (surface && IMG_SavePNG(surface, golden_png)) {
+        printf("golden: wrote %s\n", golden_png);
+    } else {
+        fprintf(stderr, "golden: could not write %s: %s\n", golden_png, SDL_GetError());
+    }
+    if (surface) SDL_DestroySurface(surface);
+    return 1;
+}
+
+void power_off_devices(cpu_state *cpu, SystemConfig_t *system_config) {
+    for (int i = 0; system_config->device_map[i].id != DEVICE_ID_END; i++) {
+        DeviceMap_t dm = system_config->device_map[i];
+        Device_t *device = get_device(dm.id);
+        if (device->power_off) {
+            device->power_off(cpu, dm.slot);
+        }
+    }
+}
+
 gs2_app_t gs2_app_values;
 
+/** -d, and [media] in a system config: first image goes in now, the rest become the drive's playlist. */
+static void add_disk(int slot, int drive, const char *spec, std::vector<disk_mount_t> &disks_to_mount,
+                     std::vector<std::pair<uint64_t, std::vector<std::string>>> &playlists) {
+    if (slot < 1 || slot >= NUM_SLOTS || drive < 0 || drive >= DRIVES_PER_SLOT) {
+        fprintf(stderr, "No such drive s%dd%d. Slots are 1-7, drives 1-%d\n", slot, drive + 1, DRIVES_PER_SLOT);
+        exit(1);
+    }
+    std::vector<std::string> images = parse_playlist(spec);
+    if (images.empty()) {
+        fprintf(stderr, "No images in %s\n", spec);
+        exit(1);
+    }
+    printf("Mounting disk %s in slot %d drive %d\n", images[0].c_str(), slot, drive);
+    disks_to_mount.push_back({slot, drive, strdup(images[0].c_str())});
+    if (images.size() > 1) {
+        playlists.push_back({(uint64_t)((slot << 8) | drive), images});
+    }
+}
+
 int main(int argc, char *argv[]) {
     std::cout << "Booting GSSquared!" << std::endl;
 
     int platform_id = PLATFORM_APPLE_II_PLUS;  // default to Apple II Plus
     int opt;
     
-    char slot_str[2], drive_str[2], filename[256];
+    char slot_str[2], drive_str[2];
     int slot, drive;
     
     std::vector<disk_mount_t> disks_to_mount;
+    std::vector<std::pair<uint64_t, std::vector<std::string>>> playlists;
+    bool loader_jump = false;
+    int color_mode = DM_COLOR_MODE;
+    LoadedSystemConfig_t *loaded_config = nullptr;
 
     if (isatty(fileno(stdin))) {
         gs2_app_values.console_mode = true;
     }
 
-    if (gs2_app_values.console_mode) {
-        gs2_app_values.base_path = "./resources/";
-    } else {
-        gs2_app_values.base_path = SDL_GetBasePath();
-    }
-
-    if (gs2_app_values.console_mode) {
+    // headless runs come from scripts and ctest, where stdin isn't a terminal, so take options whenever we get them.
+    if (gs2_app_values.console_mode || argc > 1) {
         // parse command line optionss
-        while ((opt = getopt(argc, argv, "p:a:b:d:")) != -1) {
+        while ((opt = getopt(argc, argv, "p:a:b:d:m:M:xH:G:P:c:AJw:F:S:T:C:I")) != -1) {
             switch (opt) {
                 case 'p':
                     platform_id = atoi(optarg);
@@ -358,24 +541,108 @@ int main(int argc, char *argv[]) {
                 case 'b':
                     loader_set_file_info(optarg, 0x7000);
                     break;
-                case 'd':
-                    if (sscanf(optarg, "s%[0-9]d%[0-9]=%[^\n]", slot_str, drive_str, filename) != 3) {
-                        fprintf(stderr, "Invalid disk format. Expected sXdY=filename\n");
+                case 'd': {
+                    int spec_at = 0; // the image list can be any length, so take it straight from optarg
+                    if (sscanf(optarg, "s%1[0-9]d%1[0-9]=%n", slot_str, drive_str, &spec_at) != 2 || spec_at == 0 || optarg[spec_at] == 0) {
+                        fprintf(stderr, "Invalid disk format. Expected sXdY=filename, sXdY=a,b,... or sXdY=@playlist\n");
                         exit(1);
                     }
                     slot = atoi(slot_str);
                     drive = atoi(drive_str)-1;
-                    
-                    printf("Mounting disk %s in slot %d drive %d\n", filename, slot, drive);
-                    disks_to_mount.push_back({slot, drive, strndup(filename, 256)});
+                    add_disk(slot, drive, optarg + spec_at, disks_to_mount, playlists);
+                    break;
+                }
+                case 'C': {
+                    // options after -C override the file, options before it get overridden.
+                    loaded_config = load_system_config(optarg);
+                    if (!loaded_config) {
+                        exit(1);
+                    }
+                    platform_id = loaded_config->config.platform_id;
+                    if (loaded_config->color_mode >= 0) color_mode = loaded_config->color_mode;
+                    if (loaded_config->clock_epoch_set) gs2_app_values.clock_epoch = loaded_config->clock_epoch;
+                    for (const SystemConfigMedia_t &m : loaded_config->media) {
+                        add_disk(m.slot, m.drive, m.images.c_str(), disks_to_mount, playlists);
+                    }
+                    break;
+                }
+                case 'S': {
+                    unsigned long long cycle;
+                    char action[16] = "";
+                    if (sscanf(optarg, "%llu:s%1[0-9]d%1[0-9]:%15s", &cycle, slot_str, drive_str, action) < 3
+                        || (action[0] && strcmp(action, "eject") != 0)) {
+                        fprintf(stderr, "Invalid swap format. Expected cycles:sXdY or cycles:sXdY:eject\n");
+                        exit(1);
+                    }
+                    slot = atoi(slot_str);
+                    drive = atoi(drive_str) - 1;
+                    if (slot < 1 || slot >= NUM_SLOTS || drive < 0 || drive >= DRIVES_PER_SLOT) {
+                        fprintf(stderr, "No such drive s%dd%d. Slots are 1-7, drives 1-%d\n", slot, drive + 1, DRIVES_PER_SLOT);
+                        exit(1);
+                    }
+                    uint64_t key = (slot << 8) | drive;
+                    disk_swaps.push_back({cycle, key, action[0] != 0});
+                    break;
+                }
+                case 'm':
+                    memexp_set_backing_file(optarg);
+                    break;
+                case 'M':
+                    memexp_set_size(atoi(optarg) * 1024);
+                    break;
+                case 'x':
+                    loader_jump = true;
+                    break;
+                case 'A':
+                    gs2_app_values.no_audio = true;
+                    break;
+                case 'J':
+                    gs2_app_values.no_joystick = true;
+                    break;
+                case 'w':
+                    gs2_app_values.audio_capture = optarg;
+                    break;
+                case 'F':
+                    gs2_app_values.frame_skip = atoi(optarg);
+                    break;
+                case 'T':
+                    gs2_app_values.clock_epoch = strtoll(optarg, nullptr, 10);
+                    break;
+                case 'H':
+                    gs2_app_values.headless = true;
+                    gs2_app_values.no_audio = true;
+                    gs2_app_values.no_joystick = true;
+                    golden_cycles = strtoull(optarg, nullptr, 10);
+                    break;
+                case 'I':
+                    golden_wait_idle = true;
+                    break;
+                case 'G':
+                    golden_hash = strtoull(optarg, nullptr, 16);
+                    golden_hash_set = true;
+                    break;
+                case 'P':
+                    golden_png = optarg;
+                    break;
+                case 'c':
+                    color_mode = atoi(optarg);
+                    if (color_mode < 0 || color_mode >= DM_NUM_MODES) color_mode = DM_COLOR_MODE;
                     break;
                 default:
-                    fprintf(stderr, "Usage: %s [-p platform] [-a program.bin] [-b loader.bin]\n", argv[0]);
+                    fprintf(stderr, "Usage: %s [-C system.ini] [-p platform] [-a program.bin] [-b loader.bin] [-x] [-m ramdisk.img] [-M ramdisk_kb]\n", argv[0]);
+                    fprintf(stderr, "          [-H cycles] [-I] [-G golden_hash] [-P mismatch.png] [-c color_mode] [-A] [-J] [-w capture.wav] [-F n] [-T epoch]\n");
+                    fprintf(stderr, "          [-d sXdY=image[,image...]] [-d sXdY=@playlist.txt] [-S cycles:sXdY[:eject]]\n");
                     exit(1);
             }
         }
     }
 
+    if (gs2_app_values.console_mode || gs2_app_values.headless) {
+        gs2_app_values.base_path = "./resources/";
+    } else {
+        gs2_app_values.base_path = SDL_GetBasePath();
+    }
+
     // Debug print mounted media
     std::cout << "Mounted Media (" << disks_to_mount.size() << " disks):" << std::endl;
     for (const auto& disk_mount : disks_to_mount) {
@@ -385,6 +652,9 @@ int main(int argc, char *argv[]) {
     /* system_diag((char *)gs2_app_values.base_path); */
 
     init_cpus();
+    if (loaded_config && loaded_config->clock_mode >= 0) {
+        set_clock_mode(&CPUs[0], (clock_mode)loaded_config->clock_mode);
+    }
 
 #if 0
         // this is the one test system.
@@ -434,24 +704,33 @@ int main(int argc, char *argv[]) {
         // Load into memory at correct address
         printf("Main Rom Data: %p base_addr: %04X size: %zu\n", rd->main_rom_data, rd->main_base_addr, rd->main_rom_file->size());
         for (uint64_t i = 0; i < rd->main_rom_file->size(); i++) {
-            raw_memory_write(&CPUs[0], rd->main_base_addr + i, (*rd->main_rom_data)[i]);
+            uint16_t addr = rd->main_base_addr + i;
+            if (addr < 0xD000) { // IIe internal $C100-$CFFF ROM. Kept aside; the IIe memory device maps it in.
+                if (CPUs[0].main_rom_C0 == nullptr) CPUs[0].main_rom_C0 = new uint8_t[IO_KB]();
+                CPUs[0].main_rom_C0[addr - 0xC000] = (*rd->main_rom_data)[i];
+                continue;
+            }
+            raw_memory_write(&CPUs[0], addr, (*rd->main_rom_data)[i]);
         }
         // we could dispose of this now if we wanted..
 #endif
 
     set_cpu_processor(&CPUs[0], platform->processor_type);
-    CPUs[0].mounts = new Mounts(&CPUs[0]); // TODO: this should happen in a CPU constructor.
+    SlotManager_t *slot_manager = new SlotManager_t();
+    CPUs[0].mounts = new Mounts(&CPUs[0], slot_manager); // TODO: this should happen in a CPU constructor.
 
     init_display_font(rd);
 
-    SystemConfig_t *system_config = get_system_config(1);
-
-    SlotManager_t *slot_manager = new SlotManager_t();
+    SystemConfig_t *system_config = loaded_config ? &loaded_config->config : get_system_config_for_platform(platform_id);
 
     for (int i = 0; system_config->device_map[i].id != DEVICE_ID_END; i++) {
         DeviceMap_t dm = system_config->device_map[i];
 
         Device_t *device = get_device(dm.id);
+        if (device->power_on == NULL) {
+            fprintf(stderr, "Device %s isn't implemented, skipping it\n", device->name);
+            continue;
+        }
         device->power_on(&CPUs[0], dm.slot);
         if (dm.slot != SLOT_NONE) {
             slot_manager->register_slot(device, dm.slot);
@@ -468,9 +747,26 @@ int main(int argc, char *argv[]) {
         disks_to_mount.pop_back(); 
 
         CPUs[0].mounts->mount_media(disk_mount);
+        free(disk_mount.filename);
+    }
+    for (auto &playlist : playlists) {
+        CPUs[0].mounts->set_playlist(playlist.first, playlist.second); // starts the prefetch of image 2
+    }
+    std::stable_sort(disk_swaps.begin(), disk_swaps.end(), [](const disk_swap_t &a, const disk_swap_t &b) { return a.cycle < b.cycle; });
+
+    if (loader_jump) {
+        loader_run(&CPUs[0]);
     }
 
     display_state_t *ds = (display_state_t *)get_module_state(&CPUs[0], MODULE_DISPLAY);
+    ds->color_mode = (display_color_mode_t)color_mode;
+
+    if (gs2_app_values.headless) {
+        int status = run_golden(&CPUs[0]);
+        power_off_devices(&CPUs[0], system_config);
+        return status;
+    }
+
     osd = new OSD(&CPUs[0], ds->renderer, ds->window, slot_manager, 1120, 768);
     // TODO: this should be handled differently. have osd save/restore?
     int error = SDL_SetRenderTarget(ds->renderer, nullptr);
@@ -500,6 +796,8 @@ int main(int argc, char *argv[]) {
 
     //dump_full_speaker_event_log();
 
+    power_off_devices(&CPUs[0], system_config);
+
     free_display(&CPUs[0]);
     
     debug_dump_memory(&CPUs[0], 0x1230, 0x123F);
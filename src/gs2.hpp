@@ -34,6 +34,12 @@ typedef uint8_t opcode_t;
 typedef struct gs2_app_t {
     const char *base_path;
     bool console_mode = false;
+    bool headless = false; // no window, no audio device. set by -H.
+    bool no_audio = false; // never open an audio device. samples are still made if audio_capture is set.
+    bool no_joystick = false; // never bring up the SDL joystick subsystem; paddles follow the mouse.
+    const char *audio_capture = nullptr; // if set, write the speaker output here as a .wav.
+    int frame_skip = 0; // free run: present every Nth emulated frame. 0 = at most once per host refresh.
+    int64_t clock_epoch = 0; // -T: if set, clock cards run on virtual time from here (Unix time, UTC). see util/wall_clock.hpp
 } gs2_app_t;
 
 extern gs2_app_t gs2_app_values;
@@ -15,6 +15,7 @@
  *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
 #include <iostream>
 #include <unistd.h>
 #include <sstream>
@@ -150,13 +151,66 @@ void memory_map_page_both(cpu_state *cpu, uint16_t page, uint8_t *data, memory_t
     cpu->memory->pages_write[page] = data;
 }
 
+/**
+ * Keep a copy of the default page table so a reset can put it back with a
+ * few memcpy's instead of rebuilding it. Devices that map over it (language
+ * card, IIe memory) redo their part from their reset handlers.
+ */
+void save_reset_memory_map(cpu_state *cpu) {
+    if (cpu->reset_memory == nullptr) {
+        cpu->reset_memory = new memory_map();
+    }
+    memcpy(cpu->reset_memory->page_info, cpu->memory->page_info, sizeof(cpu->memory->page_info));
+    memcpy(cpu->reset_memory->pages_read, cpu->memory->pages_read, sizeof(cpu->memory->pages_read));
+    memcpy(cpu->reset_memory->pages_write, cpu->memory->pages_write, sizeof(cpu->memory->pages_write));
+}
+
+/* video_observer is left alone; the display keeps that current itself. */
+void restore_reset_memory_map(cpu_state *cpu) {
+    memcpy(cpu->memory->page_info, cpu->reset_memory->page_info, sizeof(cpu->memory->page_info));
+    memcpy(cpu->memory->pages_read, cpu->reset_memory->pages_read, sizeof(cpu->memory->pages_read));
+    memcpy(cpu->memory->pages_write, cpu->reset_memory->pages_write, sizeof(cpu->memory->pages_write));
+    cpu->C8xx_slot = 0xFF;
+}
+
 void register_C8xx_handler(cpu_state *cpu, uint8_t slot, void (*handler)(cpu_state *cpu)) {
     cpu->C8xx_handlers[slot] = handler;
 }
 
+/**
+ * Cards with a plain 2K expansion ROM register it here instead of a handler.
+ * The page pointers are worked out now, so selecting the slot is one copy of
+ * an 8-entry block.
+ */
+void register_C8xx_rom(cpu_state *cpu, uint8_t slot, uint8_t *rom) {
+    for (int page = 0; page < 8; page++) {
+        cpu->C8xx_rom_pages[slot][page] = rom ? rom + page * GS2_PAGE_SIZE : nullptr;
+    }
+}
+
+static inline void map_C8xx_pages(cpu_state *cpu, uint8_t * const *pages) {
+    memcpy(&cpu->memory->pages_read[0xC8], pages, 8 * sizeof(uint8_t *));
+    memcpy(&cpu->memory->pages_write[0xC8], pages, 8 * sizeof(uint8_t *));
+}
+
 void call_C8xx_handler(cpu_state *cpu, uint8_t slot) {
+    if (cpu->C8xx_rom_pages[slot][0] != nullptr) {
+        map_C8xx_pages(cpu, cpu->C8xx_rom_pages[slot]);
+    }
     if (cpu->C8xx_handlers[slot] != nullptr) {
         cpu->C8xx_handlers[slot](cpu);
     }
     cpu->C8xx_slot = slot;
+}
+
+/**
+ * $CFFF: deselect the slot's $C800 ROM. Firmware hits this on every call just
+ * in case, so when nothing is selected there is nothing to do.
+ */
+void release_C8xx(cpu_state *cpu) {
+    if (cpu->C8xx_slot == 0xFF) {
+        return;
+    }
+    map_C8xx_pages(cpu, cpu->C8xx_idle_pages);
+    cpu->C8xx_slot = 0xFF;
 }
\ No newline at end of file
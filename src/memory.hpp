@@ -38,5 +38,9 @@ void store_byte(cpu_state *cpu, uint16_t address, uint8_t value);
 void store_word(cpu_state *cpu, uint16_t address, uint16_t value);
 uint8_t read_byte_from_pc(cpu_state *cpu);
 void memory_map_page_both(cpu_state *cpu, uint16_t page, uint8_t *data, memory_type type);
+void save_reset_memory_map(cpu_state *cpu);
+void restore_reset_memory_map(cpu_state *cpu);
 void register_C8xx_handler(cpu_state *cpu, uint8_t slot, void (*handler)(cpu_state *cpu));
-void call_C8xx_handler(cpu_state *cpu, uint8_t slot);
\ No newline at end of file
+void call_C8xx_handler(cpu_state *cpu, uint8_t slot);
+void register_C8xx_rom(cpu_state *cpu, uint8_t slot, uint8_t *rom);
+void release_C8xx(cpu_state *cpu);
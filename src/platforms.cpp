@@ -28,8 +28,8 @@
 static  platform_info platforms[] = {
     { PLATFORM_APPLE_II, "Apple II", "apple2", 0xD000, PROCESSOR_6502, CLOCK_1_024MHZ },
     { PLATFORM_APPLE_II_PLUS, "Apple II Plus", "apple2_plus", 0xD000, PROCESSOR_6502, CLOCK_1_024MHZ },
-    { PLATFORM_APPLE_IIE, "Apple IIe",     "apple2e", 0xD000, PROCESSOR_6502, CLOCK_1_024MHZ },
-    { PLATFORM_APPLE_IIE_ENHANCED, "Apple IIe Enhanced",     "apple2e_enhanced", 0xD000, PROCESSOR_65C02, CLOCK_1_024MHZ },
+    { PLATFORM_APPLE_IIE, "Apple IIe",     "apple2e", 0xC000, PROCESSOR_6502, CLOCK_1_024MHZ },
+    { PLATFORM_APPLE_IIE_ENHANCED, "Apple IIe Enhanced",     "apple2e_enhanced", 0xC000, PROCESSOR_65C02, CLOCK_1_024MHZ },
     // Add more platforms as needed:
     // { "Apple IIc",         "apple2c" },
     // { "Apple IIc Plus",    "apple2c_plus" },
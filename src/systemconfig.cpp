@@ -1,5 +1,12 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
 #include "gs2.hpp"
 #include "systemconfig.hpp"
+#include "display/display.hpp"
+#include "util/mount.hpp"
 
 
 DeviceMap_t DeviceMap_II[] = {
@@ -21,7 +28,13 @@ DeviceMap_t DeviceMap_IIPLUS[] = {
 };
 
 DeviceMap_t DeviceMap_IIE[] = {
-    {DEVICE_ID_KEYBOARD_IIE, SLOT_NONE},
+    {DEVICE_ID_KEYBOARD_IIPLUS, SLOT_NONE}, // until DEVICE_ID_KEYBOARD_IIE exists
+    {DEVICE_ID_SPEAKER, SLOT_NONE},
+    {DEVICE_ID_DISPLAY, SLOT_NONE},
+    {DEVICE_ID_GAMECONTROLLER, SLOT_NONE},
+    {DEVICE_ID_LANGUAGE_CARD, SLOT_0},
+    {DEVICE_ID_DISK_II, SLOT_6},
+    {DEVICE_ID_IIE_MEMORY, SLOT_NONE}, // after the display and the slots, see init_mb_iie_memory
     {DEVICE_ID_END, SLOT_NONE}
 };
 
@@ -56,3 +69,278 @@ SystemConfig_t BuiltinSystemConfigs[] = {
 SystemConfig_t *get_system_config(int index) {
     return &BuiltinSystemConfigs[index];
 }
+
+/**
+ * The built-in machine for a platform (-p). The plain Apple ][ map has no
+ * display, so that platform gets the ][+ devices too.
+ */
+SystemConfig_t *get_system_config_for_platform(int platform_id) {
+    switch (platform_id) {
+        case PLATFORM_APPLE_IIE:
+        case PLATFORM_APPLE_IIE_ENHANCED:
+            return get_system_config(2);
+        default:
+            return get_system_config(1);
+    }
+}
+
+/**
+ * System config files. Plain INI:
+ *
+ *   [system]
+ *   name = My II+
+ *   platform = apple2_plus        ; roms/ directory name, or the -p number
+ *   clock = 1mhz                  ; 1mhz, 2.8mhz, 4mhz or free
+ *   color = green                 ; color, green or amber
+ *   clock_epoch = 0               ; same as -T, 0 = host clock
+ *
+ *   [devices]                     ; powered on in this order
+ *   keyboard_iiplus
+ *   speaker
+ *   display
+ *   languagecard = 0
+ *   diskii = 6
+ *
+ *   [media]
+ *   s6d1 = disk1.dsk,disk2.dsk    ; same as -d
+ *
+ *   [slot4]                       ; settings for the card in slot 4
+ *   size = 2048                   ; see the card's set_option
+ *
+ * Everything is checked against the device registry before we return, so
+ * main() can power on whatever we hand back.
+ */
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *e = s + strlen(s);
+    while (e > s && isspace((unsigned char)e[-1])) e--;
+    *e = 0;
+    return s;
+}
+
+static const char *clock_mode_names[NUM_CLOCK_MODES] = { "free", "1mhz", "2.8mhz", "4mhz" };
+static const char *color_mode_names[DM_NUM_MODES] = { "color", "green", "amber" };
+
+static int lookup_name(const char **names, int count, const char *value) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(names[i], value) == 0) return i;
+    }
+    return -1;
+}
+
+static bool validate_device(const char *filename, int line, const DeviceKey_t *dk, int slot, LoadedSystemConfig_t *sc) {
+    if (get_device(dk->id)->power_on == NULL) {
+        fprintf(stderr, "%s:%d: device %s isn't implemented\n", filename, line, dk->key);
+        return false;
+    }
+    if (dk->slot_card) {
+        if (slot == SLOT_NONE) {
+            fprintf(stderr, "%s:%d: %s is a slot card, give it a slot: %s = N\n", filename, line, dk->key, dk->key);
+            return false;
+        }
+        // slot 0 is the language card's and nothing else's.
+        if ((dk->id == DEVICE_ID_LANGUAGE_CARD) != (slot == SLOT_0)) {
+            fprintf(stderr, "%s:%d: %s can't go in slot %d\n", filename, line, dk->key, slot);
+            return false;
+        }
+    } else if (slot != SLOT_NONE) {
+        fprintf(stderr, "%s:%d: %s is on the motherboard, it doesn't take a slot\n", filename, line, dk->key);
+        return false;
+    }
+    for (const DeviceMap_t &dm : sc->device_map) {
+        if (dm.id == dk->id && !dk->multiple) {
+            if (dk->slot_card) {
+                fprintf(stderr, "%s:%d: %s is already in slot %d, only one is supported\n", filename, line, dk->key, dm.slot);
+            } else {
+                fprintf(stderr, "%s:%d: %s is already installed\n", filename, line, dk->key);
+            }
+            return false;
+        }
+        if (slot != SLOT_NONE && dm.slot == slot) {
+            fprintf(stderr, "%s:%d: slot %d is already taken by %s\n", filename, line, slot, get_device(dm.id)->name);
+            return false;
+        }
+    }
+    return true;
+}
+
+LoadedSystemConfig_t *load_system_config(const char *filename) {
+    FILE *f = fopen(filename, "r");
+    if (!f) {
+        fprintf(stderr, "Can't open system config %s\n", filename);
+        return nullptr;
+    }
+
+    LoadedSystemConfig_t *sc = new LoadedSystemConfig_t();
+    sc->name = filename;
+    int platform_id = PLATFORM_APPLE_II_PLUS;
+    bool devices_given = false;
+    bool ok = true;
+
+    char buf[1024];
+    char section[32] = "";
+    int line = 0;
+    while (ok && fgets(buf, sizeof(buf), f)) {
+        line++;
+        char *semi = strpbrk(buf, ";#");
+        if (semi) *semi = 0;
+        char *s = trim(buf);
+        if (!*s) continue;
+
+        if (*s == '[') {
+            char *end = strchr(s, ']');
+            if (!end) {
+                fprintf(stderr, "%s:%d: bad section header\n", filename, line);
+                ok = false;
+                break;
+            }
+            *end = 0;
+            snprintf(section, sizeof(section), "%s", trim(s + 1));
+            if (strcmp(section, "devices") == 0) devices_given = true;
+            continue;
+        }
+
+        char *key = s;
+        char *value = nullptr;
+        char *eq = strchr(s, '=');
+        if (eq) {
+            *eq = 0;
+            key = trim(s);
+            value = trim(eq + 1);
+        }
+
+        if (strcmp(section, "system") == 0 && value) {
+            if (strcmp(key, "name") == 0) {
+                sc->name = value;
+            } else if (strcmp(key, "platform") == 0) {
+                platform_info *pi = find_platform_by_dir(value);
+                char *num_end;
+                long n = strtol(value, &num_end, 10);
+                if (pi) {
+                    platform_id = pi->id;
+                } else if (*num_end == 0 && get_platform(n)) {
+                    platform_id = n;
+                } else {
+                    fprintf(stderr, "%s:%d: unknown platform %s\n", filename, line, value);
+                    ok = false;
+                }
+            } else if (strcmp(key, "clock") == 0) {
+                sc->clock_mode = lookup_name(clock_mode_names, NUM_CLOCK_MODES, value);
+                if (sc->clock_mode < 0) {
+                    fprintf(stderr, "%s:%d: unknown clock %s (1mhz, 2.8mhz, 4mhz or free)\n", filename, line, value);
+                    ok = false;
+                }
+            } else if (strcmp(key, "color") == 0) {
+                sc->color_mode = lookup_name(color_mode_names, DM_NUM_MODES, value);
+                if (sc->color_mode < 0) {
+                    fprintf(stderr, "%s:%d: unknown color mode %s (color, green or amber)\n", filename, line, value);
+                    ok = false;
+                }
+            } else if (strcmp(key, "clock_epoch") == 0) {
+                sc->clock_epoch = strtoll(value, nullptr, 10);
+                sc->clock_epoch_set = true;
+            } else {
+                fprintf(stderr, "%s:%d: unknown setting %s\n", filename, line, key);
+                ok = false;
+            }
+        } else if (strcmp(section, "devices") == 0) {
+            const DeviceKey_t *dk = find_device_key(key);
+            if (!dk) {
+                fprintf(stderr, "%s:%d: unknown device %s\n", filename, line, key);
+                ok = false;
+                break;
+            }
+            int slot = SLOT_NONE;
+            if (value) {
+                char *num_end;
+                slot = (int)strtol(value, &num_end, 10);
+                if (!*value || *num_end || slot < SLOT_0 || slot >= NUM_SLOTS) {
+                    fprintf(stderr, "%s:%d: bad slot %s\n", filename, line, value);
+                    ok = false;
+                    break;
+                }
+            }
+            ok = validate_device(filename, line, dk, slot, sc);
+            if (ok) sc->device_map.push_back({dk->id, (SlotType_t)slot});
+        } else if (strcmp(section, "media") == 0 && value) {
+            int slot, drive;
+            char tail;
+            if (sscanf(key, "s%dd%d%c", &slot, &drive, &tail) != 2 || slot < 1 || slot >= NUM_SLOTS
+                || drive < 1 || drive > DRIVES_PER_SLOT || !*value) {
+                fprintf(stderr, "%s:%d: expected sXdY = image, X 1-7, Y 1-%d\n", filename, line, DRIVES_PER_SLOT);
+                ok = false;
+                break;
+            }
+            sc->media.push_back({slot, drive - 1, value});
+        } else if (strncmp(section, "slot", 4) == 0 && value) {
+            int slot;
+            char tail;
+            if (sscanf(section + 4, "%d%c", &slot, &tail) != 1 || slot < SLOT_0 || slot >= NUM_SLOTS) {
+                fprintf(stderr, "%s:%d: bad section [%s]\n", filename, line, section);
+                ok = false;
+                break;
+            }
+            sc->settings.push_back({slot, line, key, value});
+        } else {
+            fprintf(stderr, "%s:%d: don't know what to do with \"%s\"\n", filename, line, key);
+            ok = false;
+        }
+    }
+    fclose(f);
+
+    if (ok) {
+        bool has_display = false;
+        for (const DeviceMap_t &dm : sc->device_map) {
+            if (dm.id == DEVICE_ID_DISPLAY) has_display = true;
+        }
+        if (!devices_given) {
+            fprintf(stderr, "%s: no [devices] section\n", filename);
+            ok = false;
+        } else if (!has_display) {
+            fprintf(stderr, "%s: the display device is required\n", filename);
+            ok = false;
+        }
+    }
+    if (ok) {
+        // media has to go in a drive controller we actually installed.
+        for (const SystemConfigMedia_t &m : sc->media) {
+            bool found = false;
+            for (const DeviceMap_t &dm : sc->device_map) {
+                if (dm.slot == m.slot && get_device(dm.id)->mount) found = true;
+            }
+            if (!found) {
+                fprintf(stderr, "%s: no drive controller in slot %d for s%dd%d\n", filename, m.slot, m.slot, m.drive + 1);
+                ok = false;
+            }
+        }
+    }
+    if (ok) {
+        // settings go to whatever card ended up in that slot, once the whole file is read.
+        for (const SystemConfigSetting_t &st : sc->settings) {
+            Device_t *device = nullptr;
+            for (const DeviceMap_t &dm : sc->device_map) {
+                if (dm.slot == st.slot) device = get_device(dm.id);
+            }
+            if (!device) {
+                fprintf(stderr, "%s:%d: no card in slot %d\n", filename, st.line, st.slot);
+                ok = false;
+            } else if (!device->set_option || !device->set_option((SlotType_t)st.slot, st.key.c_str(), st.value.c_str())) {
+                fprintf(stderr, "%s:%d: %s doesn't take %s = %s\n", filename, st.line, device->name, st.key.c_str(), st.value.c_str());
+                ok = false;
+            }
+            if (!ok) break;
+        }
+    }
+    if (!ok) {
+        delete sc;
+        return nullptr;
+    }
+
+    sc->device_map.push_back({DEVICE_ID_END, SLOT_NONE});
+    sc->config.name = sc->name.c_str();
+    sc->config.platform_id = (PlatformId_t)platform_id;
+    sc->config.device_map = sc->device_map.data();
+    sc->config.builtin = false;
+    return sc;
+}
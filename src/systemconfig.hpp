@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "gs2.hpp"
 #include "platforms.hpp"
 #include "devices.hpp"
@@ -17,3 +20,36 @@ struct SystemConfig_t {
 extern SystemConfig_t BuiltinSystemConfigs[];
 
 SystemConfig_t *get_system_config(int index);
+SystemConfig_t *get_system_config_for_platform(int platform_id);
+
+/**
+ * A system configuration read from a file at startup (-C). config points
+ * into device_map, so keep the whole thing around for as long as the
+ * machine is running. Settings the file doesn't give are -1 / empty.
+ */
+struct SystemConfigMedia_t {
+    int slot;
+    int drive;
+    std::string images; // same syntax as -d: image, image,image,... or @playlist
+};
+
+struct SystemConfigSetting_t {
+    int slot;
+    int line;
+    std::string key;
+    std::string value; // handed to the card as a const char *, so this has to stay put
+};
+
+struct LoadedSystemConfig_t {
+    SystemConfig_t config;
+    std::string name;
+    std::vector<DeviceMap_t> device_map; // ends with DEVICE_ID_END
+    std::vector<SystemConfigMedia_t> media;
+    std::vector<SystemConfigSetting_t> settings;
+    int clock_mode = -1;
+    int color_mode = -1;
+    bool clock_epoch_set = false;
+    int64_t clock_epoch = 0;
+};
+
+LoadedSystemConfig_t *load_system_config(const char *filename);
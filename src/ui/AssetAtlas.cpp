@@ -24,6 +24,7 @@
 #include "gs2.hpp"
 #include "AssetAtlas.hpp"
 #include "util/dialog.hpp"
+#include "util/EmbeddedResources.hpp"
 
 AssetAtlas_t::AssetAtlas_t(SDL_Renderer *renderer, char *path, int target_w, int target_h) : renderer(renderer)
 {
@@ -34,14 +35,22 @@ AssetAtlas_t::AssetAtlas_t(SDL_Renderer *renderer, char *path, int target_w, int
     filename_t.assign(gs2_app_values.base_path);
     filename_t.append(path);
 
-    SDL_Surface* original = IMG_Load(filename_t.c_str());
+    // embedded builds carry the atlas already decoded, so skip the PNG decode.
+    SDL_Surface* original;
+    const embedded_resource_t *embedded = find_embedded_resource(path);
+    if (embedded) {
+        original = SDL_CreateSurfaceFrom(embedded->width, embedded->height, SDL_PIXELFORMAT_RGBA32,
+            (void *)embedded->data, embedded->width * 4);
+    } else {
+        original = IMG_Load(filename_t.c_str());
+    }
     if (!original) {
         char error_message[256];
         snprintf(error_message, sizeof(error_message), "Failed to load image: %s", path);
         system_failure(error_message);
     }
     
-    if (target_w > 0 && target_h > 0) {
+    if (target_w > 0 && target_h > 0 && (target_w != original->w || target_h != original->h)) {
         SDL_Surface* scaled = SDL_CreateSurface(target_w, target_h, SDL_PIXELFORMAT_RGBA8888);
         SDL_BlitSurfaceScaled(original, NULL, scaled, NULL, SDL_SCALEMODE_LINEAR);
         image = SDL_CreateTextureFromSurface(renderer, scaled);
@@ -59,12 +59,14 @@ static void /* SDLCALL */ file_dialog_callback(void* userdata, const char* const
     printf("file_dialog_callback: %s\n", filelist[0]);
     // 1. unmount current image (if present).
     // 2. mount new image.
+    // this can be called on another thread, and the image load is slow. Queue
+    // both; the emulation loop swaps the disk in once it's ready.
     disk_mount_t dm;
     dm.filename = (char *)filelist[0];
     dm.slot = data->key >> 8;
     dm.drive = data->key & 0xFF;
-    osd->cpu->mounts->unmount_media(dm);
-    osd->cpu->mounts->mount_media(dm);
+    osd->cpu->mounts->request_unmount(dm);
+    osd->cpu->mounts->request_mount(dm);
     SDL_RaiseWindow(osd->get_window());
 }
 
@@ -229,6 +231,8 @@ OSD::OSD(cpu_state *cpu, SDL_Renderer *rendererp, SDL_Window *windowp, SlotManag
 
     // TODO: create buttons based on what is in slots.
     // Create the buttons
+    drive_status = new DriveStatusTracker(cpu->mounts->subscribe());
+
     diskii_button1 = new DiskII_Button_t(aa, DiskII_Open, DS); // this needs to have our disk key . or alternately use a different callback.
     diskii_button1->set_key(0x600);
     diskii_button1->set_click_callback(diskii_button_click, new diskii_callback_data_t{this, 0x600});
@@ -362,18 +366,14 @@ void OSD::update() {
         }
     }
 
-    static int updCount=0;
-    if (updCount++ > 60) {
-        updCount = 0;
-        cpu->mounts->dump();
-    }
-
     // TODO: iterate over all drives based on what's in slots.
-    // update disk status
-    diskii_button1->set_disk_status(cpu->mounts->media_status(0x600));
-    diskii_button2->set_disk_status(cpu->mounts->media_status(0x601));
-    unidisk_button1->set_disk_status(cpu->mounts->media_status(0x500));
-    unidisk_button2->set_disk_status(cpu->mounts->media_status(0x501));
+    // update disk status - only when the drives told us something happened.
+    if (drive_status->update(cpu->cycles)) {
+        diskii_button1->set_disk_status(drive_status->status(0x600));
+        diskii_button2->set_disk_status(drive_status->status(0x601));
+        unidisk_button1->set_disk_status(drive_status->status(0x500));
+        unidisk_button2->set_disk_status(drive_status->status(0x501));
+    }
 
     // background color update based on clock speed to highlight current button.
     speed_btn_10->set_background_color(0x000000FF);
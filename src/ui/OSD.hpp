@@ -28,6 +28,7 @@
 #include "Container.hpp"
 #include "MousePositionTile.hpp"
 #include "AssetAtlas.hpp"
+#include "util/drive_events.hpp"
 
 #define SLIDE_IN 1
 #define SLIDE_OUT 2
@@ -63,6 +64,8 @@ protected:
 
     std::vector<Container_t *> containers;
 
+    DriveStatusTracker *drive_status = nullptr;
+
     MousePositionTile_t* mouse_pos = nullptr;
     AssetAtlas_t *aa = nullptr;
     SDL_Renderer *renderer = nullptr;
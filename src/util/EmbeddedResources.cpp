@@ -0,0 +1,43 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "util/EmbeddedResources.hpp"
+
+#ifdef GS2_EMBED_RESOURCES
+
+extern const embedded_resource_t embedded_resources[];
+extern const size_t embedded_resources_count;
+
+/* a dozen or so entries, looked up a handful of times at startup. linear is fine. */
+const embedded_resource_t *find_embedded_resource(const char *name) {
+    for (size_t i = 0; i < embedded_resources_count; i++) {
+        if (strcmp(embedded_resources[i].name, name) == 0) {
+            return &embedded_resources[i];
+        }
+    }
+    return nullptr;
+}
+
+#else
+
+const embedded_resource_t *find_embedded_resource(const char *name) {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Resources compiled into the binary (cmake -DGS2_EMBED_RESOURCES=ON).
+ * The table is generated by embed_resources.py; name is the same relative
+ * path ResourceFile and AssetAtlas_t would open under base_path.
+ *
+ * Images are stored already decoded, as RGBA bytes, with width / height
+ * filled in. For everything else width and height are 0.
+ */
+typedef struct embedded_resource_t {
+    const char *name;
+    const uint8_t *data;
+    size_t size;
+    int width;
+    int height;
+} embedded_resource_t;
+
+/**
+ * Look up a resource by relative path. Returns nullptr if it isn't embedded
+ * (or this isn't an embedded build), in which case load it from disk as usual.
+ */
+const embedded_resource_t *find_embedded_resource(const char *name);
@@ -23,11 +23,13 @@
 #include <filesystem>
 #include <fstream>
 #include <stdexcept>
+#include <cstring>
 
 #include <SDL3/SDL.h>
 
 #include "gs2.hpp"
 #include "util/ResourceFile.hpp"
+#include "util/EmbeddedResources.hpp"
 #include "util/dialog.hpp"
 
 ResourceFile::ResourceFile(const char *filename, file_mode_t mode) {
@@ -35,6 +37,7 @@ ResourceFile::ResourceFile(const char *filename, file_mode_t mode) {
     error_code = 0;
     file_size = -1; // haven't read it yet.
     file_data = nullptr;
+    embedded = find_embedded_resource(filename);
 
     // generate the full path based on system values
     filename_t.assign(gs2_app_values.base_path);
@@ -49,6 +52,9 @@ ResourceFile::~ResourceFile() {
 }
 
 int ResourceFile::exists() {
+    if (embedded) {
+        return 1;
+    }
     // check if file exists   
     if (!std::filesystem::exists(filename_t)) {
         char *debugstr = new char[512];
@@ -77,6 +83,15 @@ uintmax_t ResourceFile::size() {
 }
 
 uint8_t* ResourceFile::load() {
+    // embedded build: hand out a private copy, same as if we'd read it. card
+    // ROMs get mapped with memory_map_page_both, so the compiled-in data must not.
+    if (embedded) {
+        file_size = embedded->size;
+        file_data = new uint8_t[file_size];
+        memcpy(file_data, embedded->data, file_size);
+        return file_data;
+    }
+
     // load the file into newly allocated memory.
     if (!exists()) {
         throw std::runtime_error("File does not exist: " + filename_t);            
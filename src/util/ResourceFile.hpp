@@ -35,6 +35,7 @@ typedef enum {
 class ResourceFile {
 private:
     std::string filename_t;
+    const struct embedded_resource_t *embedded; // non-null if compiled in; then there's no file I/O at all.
     file_mode_t mode_t;
     uint8_t *file_data;
     uintmax_t file_size;
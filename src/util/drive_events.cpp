@@ -0,0 +1,104 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "drive_events.hpp"
+
+bool DriveEventQueue::push(const drive_event_t &ev) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= CAPACITY) {
+        dropped++; // observer isn't keeping up. lose the event rather than block the cpu.
+        return false;
+    }
+    events[h & (CAPACITY - 1)] = ev;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+bool DriveEventQueue::pop(drive_event_t &ev) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    ev = events[t & (CAPACITY - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+bool DriveStatusTracker::update(uint64_t cycles) {
+    bool changed = false;
+    drive_event_t ev;
+
+    while (queue->pop(ev)) {
+        tracked_drive_t &d = drives[ev.key];
+        changed = true;
+        switch (ev.type) {
+            case DRIVE_EVENT_MOUNT:
+                d.status.is_mounted = true;
+                d.status.filename = ev.filename;
+                break;
+            case DRIVE_EVENT_UNMOUNT:
+                d.status.is_mounted = false;
+                d.status.filename = nullptr;
+                break;
+            case DRIVE_EVENT_MOTOR_ON:
+                d.status.motor_on = true;
+                d.motor_off_cycle = 0;
+                break;
+            case DRIVE_EVENT_MOTOR_OFF:
+                d.motor_off_cycle = ev.cycle;
+                break;
+            case DRIVE_EVENT_TRACK:
+                d.status.position = ev.value;
+                break;
+            case DRIVE_EVENT_BLOCK_READ:
+            case DRIVE_EVENT_BLOCK_WRITE:
+                d.block_device = true;
+                d.status.motor_on = true;
+                d.status.position = ev.value;
+                d.activity_until = ev.cycle + DRIVE_ACTIVITY_HOLD_CYCLES;
+                break;
+        }
+    }
+
+    // timed transitions. Only drives with something pending get looked at.
+    for (auto &it : drives) {
+        tracked_drive_t &d = it.second;
+        if (!d.status.motor_on) continue;
+        if ((d.motor_off_cycle && cycles >= d.motor_off_cycle) ||
+            (d.block_device && cycles >= d.activity_until)) {
+            d.status.motor_on = false;
+            d.motor_off_cycle = 0;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+drive_status_t DriveStatusTracker::status(uint64_t key) {
+    auto it = drives.find(key);
+    if (it == drives.end()) {
+        return {false, nullptr, false, 0};
+    }
+    return it->second.status;
+}
+
+bool DriveStatusTracker::idle() {
+    for (auto &it : drives) {
+        if (it.second.status.motor_on) return false;
+    }
+    return true;
+}
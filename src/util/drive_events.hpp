@@ -0,0 +1,101 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <unordered_map>
+
+
+/**
+ * Drive activity events.
+ *
+ * Devices publish these through Mounts::publish() when something visible happens
+ * (motor, head movement, block access, media change). Each observer (OSD, automation,
+ * whatever) subscribes and gets its own single-producer / single-consumer queue, and
+ * drains it when it feels like it. Nobody polls device internals.
+ *
+ * All timing is in cpu cycles so headless runs see the same thing every time.
+ */
+
+struct drive_status_t {
+    bool is_mounted;
+    const char *filename;
+    bool motor_on;
+    int position;
+};
+
+enum drive_event_type_t {
+    DRIVE_EVENT_MOUNT,
+    DRIVE_EVENT_UNMOUNT,
+    DRIVE_EVENT_MOTOR_ON,
+    DRIVE_EVENT_MOTOR_OFF,      // cycle is when the motor actually stops (Disk II stops a second late)
+    DRIVE_EVENT_TRACK,          // value = track
+    DRIVE_EVENT_BLOCK_READ,     // value = block
+    DRIVE_EVENT_BLOCK_WRITE,    // value = block
+};
+
+struct drive_event_t {
+    uint64_t key;               // (slot << 8) | drive, same as Mounts
+    drive_event_type_t type;
+    int32_t value;
+    uint64_t cycle;
+    const char *filename;       // MOUNT only. Points at media_descriptor filestub.
+};
+
+class DriveEventQueue {
+protected:
+    static const uint32_t CAPACITY = 1024; // power of 2
+    drive_event_t events[CAPACITY];
+    std::atomic<uint32_t> head{0};  // next slot to write. producer owns.
+    std::atomic<uint32_t> tail{0};  // next slot to read. consumer owns.
+
+public:
+    uint64_t dropped = 0;
+
+    bool push(const drive_event_t &ev);
+    bool pop(drive_event_t &ev);
+};
+
+/**
+ * Folds a stream of events into per-drive status for consumers that just want
+ * "what does the drive look like now" - i.e., the OSD.
+ */
+class DriveStatusTracker {
+protected:
+    struct tracked_drive_t {
+        drive_status_t status;
+        uint64_t motor_off_cycle;   // pending motor off; 0 = none
+        uint64_t activity_until;    // block devices: light stays on until this cycle
+        bool block_device;
+    };
+
+    DriveEventQueue *queue;
+    std::unordered_map<uint64_t, tracked_drive_t> drives;
+
+public:
+    DriveStatusTracker(DriveEventQueue *q) : queue(q) {}
+
+    /** drain the queue and apply timed transitions. returns true if any status changed. */
+    bool update(uint64_t cycles);
+    drive_status_t status(uint64_t key);
+    /** true if no motor is running and no block access is recent. */
+    bool idle();
+};
+
+#define DRIVE_ACTIVITY_HOLD_CYCLES 1000000 // block device "light" stays on ~1 second after last access
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+
+# Generate embedded_resources.cpp: the ROM images and the UI atlas compiled
+# into the binary, so startup doesn't touch the filesystem or decode a PNG.
+# Used when building with -DGS2_EMBED_RESOURCES=ON.
+#
+# Usage: embed_resources.py <output_cpp> <name>=<file> [<name>=<file> ...]
+#
+# name is the path relative to the resources directory, the same string the
+# code hands to ResourceFile / AssetAtlas_t (e.g. roms/apple2_plus/main.rom);
+# file is where to read it from at build time.
+# .png files are decoded here to raw RGBA (R,G,B,A byte order) and the width
+# and height are stored alongside; everything else is embedded as-is.
+
+import struct
+import sys
+import zlib
+
+def decode_png(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise ValueError("{}: not a PNG".format(path))
+
+    pos = 8
+    idat = b''
+    width = height = 0
+    while pos < len(data):
+        length, ctype = struct.unpack('>I4s', data[pos:pos + 8])
+        chunk = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if ctype == b'IHDR':
+            width, height, depth, color, _, _, interlace = struct.unpack('>IIBBBBB', chunk)
+            if depth != 8 or color not in (2, 6) or interlace != 0:
+                raise ValueError("{}: only 8-bit RGB/RGBA non-interlaced PNGs are supported".format(path))
+            bpp = 4 if color == 6 else 3
+        elif ctype == b'IDAT':
+            idat += chunk
+        elif ctype == b'IEND':
+            break
+
+    raw = zlib.decompress(idat)
+    stride = width * bpp
+    out = bytearray()
+    prev = bytearray(stride)
+    for y in range(height):
+        ftype = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        if ftype == 1:
+            for i in range(bpp, stride):
+                line[i] = (line[i] + line[i - bpp]) & 0xFF
+        elif ftype == 2:
+            for i in range(stride):
+                line[i] = (line[i] + prev[i]) & 0xFF
+        elif ftype == 3:
+            for i in range(stride):
+                left = line[i - bpp] if i >= bpp else 0
+                line[i] = (line[i] + ((left + prev[i]) >> 1)) & 0xFF
+        elif ftype == 4:
+            for i in range(stride):
+                a = line[i - bpp] if i >= bpp else 0
+                b = prev[i]
+                c = prev[i - bpp] if i >= bpp else 0
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                if pa <= pb and pa <= pc:
+                    pred = a
+                elif pb <= pc:
+                    pred = b
+                else:
+                    pred = c
+                line[i] = (line[i] + pred) & 0xFF
+        if bpp == 3:
+            for x in range(width):
+                out += line[x * 3:x * 3 + 3] + b'\xFF'
+        else:
+            out += line
+        prev = line
+    return bytes(out), width, height
+
+def write_array(f, symbol, data):
+    f.write("static const uint8_t {}[{}] = {{\n    ".format(symbol, len(data)))
+    for i, byte in enumerate(data):
+        if i > 0 and i % 16 == 0:
+            f.write("\n    ")
+        f.write("0x{:02X}, ".format(byte))
+    f.write("\n};\n\n")
+
+def embed_resources(output_file, pairs):
+    entries = []
+    with open(output_file, 'w') as f:
+        f.write("// Auto-generated file - do not edit\n")
+        f.write("#include <stdint.h>\n")
+        f.write("#include <stddef.h>\n\n")
+        f.write("#include \"util/EmbeddedResources.hpp\"\n\n")
+        f.write("extern const embedded_resource_t embedded_resources[];\n")
+        f.write("extern const size_t embedded_resources_count;\n\n")
+        for n, pair in enumerate(pairs):
+            name, path = pair.split('=', 1)
+            if name.endswith('.png'):
+                data, width, height = decode_png(path)
+            else:
+                with open(path, 'rb') as src:
+                    data = src.read()
+                width = height = 0
+            symbol = "embedded_data_{}".format(n)
+            write_array(f, symbol, data)
+            entries.append((name, symbol, len(data), width, height))
+
+        f.write("const embedded_resource_t embedded_resources[] = {\n")
+        for name, symbol, size, width, height in entries:
+            f.write("    {{ \"{}\", {}, {}, {}, {} }},\n".format(name, symbol, size, width, height))
+        f.write("};\n\n")
+        f.write("const size_t embedded_resources_count = {};\n".format(len(entries)))
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3:
+        print("Usage: {} <output_cpp> <name>=<file> [<name>=<file> ...]".format(sys.argv[0]))
+        sys.exit(1)
+    embed_resources(sys.argv[1], sys.argv[2:])
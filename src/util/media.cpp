@@ -17,6 +17,8 @@
 
 /* Functions to handle setting up media descriptors */
 #include <iostream>
+#include <cstring>
+#include <strings.h>
 #include <sys/stat.h>
 
 #include "gs2.hpp"
@@ -16,13 +16,12 @@
  */
 
 #include <unordered_map>
+#include <algorithm>
+#include <string.h>
 
 #include "cpu.hpp"
 #include "media.hpp"
 #include "mount.hpp"
-#include "devices/diskii/diskii.hpp"
-#include "devices/prodos_block/prodos_block.hpp"
-#include "devices/pdblock2/pdblock2.hpp"
 
 /**
  * Media Key
@@ -31,44 +30,380 @@
  * U = Unit (key & 0xFF)
  **/
 
-int Mounts::register_drive(drive_type_t drive_type, uint64_t key) {
-    mounted_media[key].drive_type = drive_type;
+int Mounts::register_drive(uint64_t key) {
+    mounted_media[key].key = key;
     return 0;
 }
 
-int Mounts::mount_media(disk_mount_t disk_mount) {
+/* the card in the slot, if it's something that takes media. */
+Device_t *Mounts::storage_device(int slot) {
+    if (slots == nullptr || slot < 0 || slot >= NUM_SLOTS) {
+        return nullptr;
+    }
+    Device_t *device = slots->get_device((SlotType_t)slot);
+    if (device == nullptr || device->mount == nullptr) {
+        return nullptr;
+    }
+    return device;
+}
 
+/**
+ * Everything about a mount that doesn't touch live device state: read and
+ * identify the image, plus whatever the controller wants done ahead of time
+ * (a Disk II nibblizes). Safe to run on the worker thread - the slot map
+ * doesn't change after startup.
+ */
+media_descriptor *Mounts::prepare_media(disk_mount_t &disk_mount) {
     fprintf(stdout,"Mounting disk %s in slot %d drive %d\n", disk_mount.filename, disk_mount.slot, disk_mount.drive);
+
+    Device_t *device = storage_device(disk_mount.slot);
+    if (device == nullptr) {
+        fprintf(stderr, "No disk controller in slot %d\n", disk_mount.slot);
+        return nullptr;
+    }
+
     media_descriptor * media = new media_descriptor();
-    media->filename = disk_mount.filename;
+    media->filename = strdup(disk_mount.filename);
     if (identify_media(*media) != 0) {
         fprintf(stderr, "Failed to identify media %s\n", disk_mount.filename);
-        return false;
+        free_media(media);
+        return nullptr;
     }
     display_media_descriptor(*media);
 
+    if (device->prepare_media && device->prepare_media(media) != 0) {
+        free_media(media);
+        return nullptr;
+    }
+    return media;
+}
+
+void Mounts::free_media(media_descriptor *media) {
+    delete media->nibblized;
+    free((void *)media->filename);
+    free((void *)media->filestub);
+    delete media;
+}
+
+int Mounts::mount_media(disk_mount_t disk_mount) {
+    media_descriptor *media = prepare_media(disk_mount);
+    if (media == nullptr) {
+        return false;
+    }
+    return attach_media(disk_mount, media);
+}
+
+/**
+ * The part that has to happen on the emulation thread. A bad slot or drive
+ * leaves whatever is in the drive alone; the old media only comes out once
+ * the new one is on its way in.
+ */
+int Mounts::attach_media(disk_mount_t &disk_mount, media_descriptor *media) {
     uint64_t key = (disk_mount.slot << 8) | disk_mount.drive;
-    mounted_media[key].media = media;
-    mounted_media[key].key = key;
+    Device_t *device = storage_device(disk_mount.slot);
 
-    // TODO: this should look up what type of disk device is in the slot
-    if (disk_mount.slot == 6) { // TODO: instead of based on slot, should be based on the card type in the slot.
-        mount_diskII(cpu, disk_mount.slot, disk_mount.drive, media);
-        mounted_media[key].drive_type = DRIVE_TYPE_DISKII;
-    } else if (disk_mount.slot == 5) {
-        //mount_prodos_block(cpu, disk_mount.slot, disk_mount.drive, media);
-        mount_pdblock2(cpu, disk_mount.slot, disk_mount.drive, media);
-        mounted_media[key].drive_type = DRIVE_TYPE_PRODOS_BLOCK;
-    } else {
-        fprintf(stderr, "Invalid slot. Expected 5 or 6\n");
+    if (disk_mount.drive < 0 || disk_mount.drive >= DRIVES_PER_SLOT || device == nullptr) {
+        fprintf(stderr, "Failed to mount %s in slot %d drive %d\n", media->filename, disk_mount.slot, disk_mount.drive);
+        free_media(media);
+        return false;
+    }
+
+    unmount_media(disk_mount); // whatever was in there before
+
+    if (device->mount(cpu, disk_mount.slot, disk_mount.drive, media) != 0) {
+        fprintf(stderr, "Failed to mount %s in slot %d drive %d\n", media->filename, disk_mount.slot, disk_mount.drive);
+        free_media(media);
+        return false;
     }
+    mounted_media[key] = {key, device, media};
 
     return key;
 }
 
+/**
+ * The controller writes back anything dirty and lets go of the media, then
+ * we free the descriptor and whatever hangs off it.
+ */
 int Mounts::unmount_media(disk_mount_t disk_mount) {
-    // TODO
-    return false;
+    uint64_t key = (disk_mount.slot << 8) | disk_mount.drive;
+    auto it = mounted_media.find(key);
+    if (it == mounted_media.end() || it->second.media == nullptr) {
+        return false;
+    }
+    if (it->second.device && it->second.device->unmount) {
+        it->second.device->unmount(cpu, disk_mount.slot, disk_mount.drive);
+    }
+    free_media(it->second.media);
+    it->second.media = nullptr;
+    return true;
+}
+
+void Mounts::request_mount(disk_mount_t disk_mount) {
+    disk_mount.filename = strdup(disk_mount.filename); // the caller's copy may not outlive the call
+    disk_mount.media = nullptr;
+    queue_request({MOUNT_REQUEST_MOUNT, disk_mount});
+}
+
+/* goes through the worker too, so it stays in order with mounts. */
+void Mounts::request_unmount(disk_mount_t disk_mount) {
+    disk_mount.filename = nullptr;
+    disk_mount.media = nullptr;
+    queue_request({MOUNT_REQUEST_UNMOUNT, disk_mount});
+}
+
+void Mounts::queue_request(mount_request_t request) {
+    std::lock_guard<std::mutex> guard(request_lock);
+    if (!worker.joinable()) {
+        worker = std::thread(&Mounts::worker_loop, this); // first use
+    }
+    if (request.type == MOUNT_REQUEST_MOUNT) {
+        request.generation = drive_generation[(request.disk_mount.slot << 8) | request.disk_mount.drive];
+    }
+    requests.push_back(request);
+    request_wake.notify_one();
+}
+
+void Mounts::worker_loop() {
+    std::unique_lock<std::mutex> guard(request_lock);
+    while (true) {
+        request_wake.wait(guard, [this] { return worker_stop || !requests.empty(); });
+        if (worker_stop) {
+            return;
+        }
+        mount_request_t request = requests.front();
+        requests.pop_front();
+        worker_busy++;
+
+        if (request.type == MOUNT_REQUEST_MOUNT || request.type == MOUNT_REQUEST_PREFETCH) {
+            guard.unlock();
+            request.disk_mount.media = prepare_media(request.disk_mount);
+            free(request.disk_mount.filename); // the descriptor has its own copy
+            request.disk_mount.filename = nullptr;
+            guard.lock();
+        }
+        ready.push_back(request);
+        worker_busy--;
+        worker_idle.notify_all();
+    }
+}
+
+void Mounts::flush_requests() {
+    {
+        std::unique_lock<std::mutex> guard(request_lock);
+        worker_idle.wait(guard, [this] { return requests.empty() && worker_busy == 0; });
+    }
+    process_requests();
+}
+
+void Mounts::process_requests() {
+    std::deque<mount_request_t> todo;
+    {
+        std::lock_guard<std::mutex> guard(request_lock);
+        if (ready.empty()) {
+            return;
+        }
+        todo.swap(ready);
+        // mounts queued before an eject() of their drive don't go in.
+        for (mount_request_t &request : todo) {
+            uint64_t key = (request.disk_mount.slot << 8) | request.disk_mount.drive;
+            if (request.type == MOUNT_REQUEST_MOUNT && request.generation != drive_generation[key] && request.disk_mount.media) {
+                free_media(request.disk_mount.media);
+                request.disk_mount.media = nullptr;
+            }
+        }
+    }
+    for (mount_request_t &request : todo) {
+        if (request.type == MOUNT_REQUEST_UNMOUNT) {
+            unmount_media(request.disk_mount);
+        } else if (request.type == MOUNT_REQUEST_PREFETCH) {
+            prefetch_arrived(request);
+        } else if (request.disk_mount.media != nullptr) {
+            attach_media(request.disk_mount, request.disk_mount.media);
+        }
+    }
+}
+
+std::vector<std::string> parse_playlist(const char *spec) {
+    std::vector<std::string> images;
+
+    if (spec[0] == '@') {
+        FILE *f = fopen(spec + 1, "r");
+        if (f == nullptr) {
+            fprintf(stderr, "Can't open playlist %s\n", spec + 1);
+            return images;
+        }
+        char line[1024];
+        while (fgets(line, sizeof(line), f)) {
+            size_t len = strcspn(line, "\r\n");
+            line[len] = 0;
+            while (len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t')) {
+                line[--len] = 0;
+            }
+            char *p = line + strspn(line, " \t");
+            if (*p == 0 || *p == '#') {
+                continue;
+            }
+            images.push_back(p);
+        }
+        fclose(f);
+        return images;
+    }
+
+    const char *p = spec;
+    while (true) {
+        const char *comma = strchr(p, ',');
+        size_t len = comma ? (size_t)(comma - p) : strlen(p);
+        if (len > 0) {
+            images.push_back(std::string(p, len));
+        }
+        if (comma == nullptr) {
+            break;
+        }
+        p = comma + 1;
+    }
+    return images;
+}
+
+/* assumes images[0] is what's in the drive now (or on its way). */
+void Mounts::set_playlist(uint64_t key, const std::vector<std::string> &images) {
+    drive_playlist_t &playlist = playlists[key];
+    if (playlist.prefetched) {
+        free_media(playlist.prefetched);
+    }
+    playlist = drive_playlist_t();
+    playlist.images = images;
+    prefetch_next(key);
+}
+
+uint64_t Mounts::playlist_key(size_t n) {
+    std::vector<uint64_t> keys;
+    for (auto &entry : playlists) {
+        keys.push_back(entry.first);
+    }
+    if (n >= keys.size()) {
+        return 0;
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys[n];
+}
+
+/* get the entry after current read and nibblized, unless that's already done or underway. */
+void Mounts::prefetch_next(uint64_t key) {
+    drive_playlist_t &playlist = playlists[key];
+    if (playlist.images.size() < 2) {
+        return;
+    }
+    size_t next = (playlist.current + 1) % playlist.images.size();
+
+    if (playlist.prefetched) {
+        if (playlist.prefetch_index == next) {
+            return;
+        }
+        free_media(playlist.prefetched); // stale
+        playlist.prefetched = nullptr;
+    }
+    if (playlist.prefetch_pending && playlist.prefetch_index == next) {
+        return;
+    }
+    // if an older prefetch is still in flight, prefetch_arrived() will see the serial doesn't match and drop it.
+    playlist.prefetch_index = next;
+    playlist.prefetch_serial++;
+    playlist.prefetch_pending = true;
+
+    mount_request_t request = {MOUNT_REQUEST_PREFETCH, {(int)(key >> 8), (int)(key & 0xFF), strdup(playlist.images[next].c_str()), nullptr}};
+    request.prefetch_serial = playlist.prefetch_serial;
+    queue_request(request);
+}
+
+void Mounts::prefetch_arrived(mount_request_t &request) {
+    uint64_t key = (request.disk_mount.slot << 8) | request.disk_mount.drive;
+    auto it = playlists.find(key);
+    if (it == playlists.end() || !it->second.prefetch_pending || it->second.prefetch_serial != request.prefetch_serial) {
+        if (request.disk_mount.media) {
+            free_media(request.disk_mount.media); // nobody wants this one any more
+        }
+        return;
+    }
+    drive_playlist_t &playlist = it->second;
+    playlist.prefetch_pending = false;
+
+    if (request.disk_mount.media == nullptr) {
+        playlist.swap_on_arrival = false; // bad image; prepare_media already said why
+        return;
+    }
+    if (playlist.swap_on_arrival && playlist.prefetch_index == playlist.current) {
+        playlist.swap_on_arrival = false;
+        attach_media(request.disk_mount, request.disk_mount.media);
+        prefetch_next(key);
+        return;
+    }
+    playlist.prefetched = request.disk_mount.media;
+}
+
+int Mounts::swap_next(uint64_t key) {
+    auto it = playlists.find(key);
+    if (it == playlists.end() || it->second.images.size() < 2) {
+        return false;
+    }
+    drive_playlist_t &playlist = it->second;
+    playlist.current = (playlist.current + 1) % playlist.images.size();
+    playlist.swap_on_arrival = false;
+
+    disk_mount_t disk_mount = {(int)(key >> 8), (int)(key & 0xFF), nullptr, nullptr};
+
+    if (playlist.prefetched && playlist.prefetch_index == playlist.current) {
+        media_descriptor *media = playlist.prefetched;
+        playlist.prefetched = nullptr;
+        attach_media(disk_mount, media);
+    } else if (playlist.prefetch_pending && playlist.prefetch_index == playlist.current) {
+        playlist.swap_on_arrival = true; // worker is nearly there
+        return true;
+    } else {
+        disk_mount.filename = (char *)playlist.images[playlist.current].c_str();
+        request_mount(disk_mount);
+    }
+    prefetch_next(key);
+    return true;
+}
+
+/**
+ * Done here and now rather than through the worker, so a swap_next() right
+ * after it (which may attach a prefetched image immediately) can't be undone
+ * by the unmount landing later. Anything already queued for the drive is
+ * from before the eject, so it's cancelled instead.
+ */
+void Mounts::eject(uint64_t key) {
+    {
+        std::lock_guard<std::mutex> guard(request_lock);
+        drive_generation[key]++;
+    }
+    auto it = playlists.find(key);
+    if (it != playlists.end()) {
+        it->second.swap_on_arrival = false;
+    }
+    unmount_media({(int)(key >> 8), (int)(key & 0xFF), nullptr, nullptr});
+}
+
+Mounts::~Mounts() {
+    {
+        std::lock_guard<std::mutex> guard(request_lock);
+        worker_stop = true;
+        request_wake.notify_one();
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+    for (auto &entry : playlists) {
+        if (entry.second.prefetched) {
+            free_media(entry.second.prefetched);
+        }
+    }
+    // anything the worker finished that nobody collected
+    for (mount_request_t &request : ready) {
+        if (request.disk_mount.media) {
+            free_media(request.disk_mount.media);
+        }
+    }
 }
 
 drive_status_t Mounts::media_status(uint64_t key) {
@@ -76,12 +411,11 @@ drive_status_t Mounts::media_status(uint64_t key) {
     if (it == mounted_media.end()) {
         return {false, nullptr, false, 0};
     }
-    if (it->second.drive_type == DRIVE_TYPE_DISKII) {
-        return diskii_status(cpu, key);
-    } else if (it->second.drive_type == DRIVE_TYPE_PRODOS_BLOCK) {
-        return pdblock2_osd_status(cpu, key);
+    Device_t *device = storage_device(key >> 8);
+    if (device && device->media_status) {
+        return device->media_status(cpu, key);
     }
-   return {false, nullptr, false, 0};
+    return {false, nullptr, false, 0};
 }
 
 void Mounts::dump() {
@@ -89,4 +423,50 @@ void Mounts::dump() {
         drive_status_t status = media_status(it->first);
         //fprintf(stdout, "Mounted media: %llu typ: %d mnt: %d mot:%d pos: %d\n", it->first, it->second.drive_type, status.is_mounted, status.motor_on, status.position);
     }
-}
\ No newline at end of file
+}
+
+/**
+ * Observers get their own queue. A new observer is caught up on what's
+ * mounted right now, since mounts usually happen before the UI exists.
+ */
+DriveEventQueue *Mounts::subscribe() {
+    DriveEventQueue *queue = new DriveEventQueue();
+    for (auto &it : mounted_media) {
+        if (it.second.media) {
+            queue->push({it.first, DRIVE_EVENT_MOUNT, 0, cpu->cycles, event_name(it.second.media->filestub)});
+        }
+    }
+    observers.push_back(queue);
+    return queue;
+}
+
+void Mounts::unsubscribe(DriveEventQueue *queue) {
+    for (auto it = observers.begin(); it != observers.end(); it++) {
+        if (*it == queue) {
+            observers.erase(it);
+            delete queue;
+            return;
+        }
+    }
+}
+
+const char *Mounts::event_name(const char *filename) {
+    if (filename == nullptr) {
+        return nullptr;
+    }
+    return event_names.insert(filename).first->c_str();
+}
+
+void Mounts::publish(uint64_t key, drive_event_type_t type, int32_t value, const char *filename) {
+    drive_event_t ev = {key, type, value, cpu->cycles, event_name(filename)};
+    for (DriveEventQueue *queue : observers) {
+        queue->push(ev);
+    }
+}
+
+void Mounts::publish_at(uint64_t key, drive_event_type_t type, uint64_t cycle) {
+    drive_event_t ev = {key, type, 0, cycle, nullptr};
+    for (DriveEventQueue *queue : observers) {
+        queue->push(ev);
+    }
+}
@@ -18,9 +18,20 @@
 #pragma once
 
 #include <unordered_map>
+#include <unordered_set>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "cpu.hpp"
 #include "media.hpp"
+#include "drive_events.hpp"
+#include "slots.hpp"
+
+#define DRIVES_PER_SLOT 2 // Disk II and pdblock2 both have two
 
 typedef struct {
     int slot;
@@ -29,37 +40,120 @@ typedef struct {
     media_descriptor *media;
 } disk_mount_t;
 
-struct drive_status_t {
-    bool is_mounted;
-    const char *filename;
-    bool motor_on;
-    int position;
+struct drive_media_t {
+    uint64_t key;
+    Device_t *device;           // the controller it was mounted through
+    media_descriptor *media;    // ours; freed on unmount
 };
 
-enum drive_type_t {
-    DRIVE_TYPE_DISKII,
-    DRIVE_TYPE_PRODOS_BLOCK,
+enum mount_request_type_t {
+    MOUNT_REQUEST_MOUNT,
+    MOUNT_REQUEST_UNMOUNT,
+    MOUNT_REQUEST_PREFETCH,     // prepare only; parked in the drive's playlist until a swap wants it
 };
 
-struct drive_media_t {
-    uint64_t key;
-    drive_type_t drive_type;
-    media_descriptor *media;
+struct mount_request_t {
+    mount_request_type_t type;
+    disk_mount_t disk_mount;    // filename is a strdup'd copy until the worker is done with it; media filled in by the worker
+    uint64_t prefetch_serial = 0;   // PREFETCH: matched against the playlist's, so a superseded one is dropped
+    uint64_t generation = 0;        // MOUNT: the drive's generation when queued; an eject since then cancels it
+};
+
+/**
+ * The images a drive cycles through (disk 1, disk 2, ... of a multi-disk
+ * title). While one is in the drive, the next one is read and nibblized on
+ * the worker so swapping to it is just a pointer swap.
+ */
+struct drive_playlist_t {
+    std::vector<std::string> images;
+    size_t current = 0;                         // index of what's in the drive
+    media_descriptor *prefetched = nullptr;     // images[prefetch_index], ready to attach
+    size_t prefetch_index = 0;
+    uint64_t prefetch_serial = 0;               // bumped for every prefetch queued
+    bool prefetch_pending = false;              // worker hasn't finished prefetch_index yet
+    bool swap_on_arrival = false;               // a swap asked for it before it was ready
 };
 
+/**
+ * Turn a -d image argument into a playlist: "a.dsk" (one image),
+ * "a.dsk,b.dsk,c.dsk", or "@list.txt" with one image per line (blank lines
+ * and # comments skipped). Returns an empty list if the manifest can't be read.
+ */
+std::vector<std::string> parse_playlist(const char *spec);
+
 class Mounts {
 protected:
     cpu_state *cpu;
+    SlotManager_t *slots;
 
     std::unordered_map<uint64_t, drive_media_t> mounted_media;
+    std::vector<DriveEventQueue *> observers;
+    /* filenames handed out in MOUNT events. Observers may hang on to them after the media is gone. */
+    std::unordered_set<std::string> event_names;
+
+    /**
+     * Mount requests from the UI. The worker thread does the slow part (read,
+     * identify, nibblize) and moves them to ready; the emulation thread picks
+     * them up in process_requests() and swaps them in. Both queues are under
+     * request_lock.
+     */
+    std::thread worker;
+    std::mutex request_lock;
+    std::condition_variable request_wake;
+    std::deque<mount_request_t> requests;
+    std::deque<mount_request_t> ready;
+    bool worker_stop = false;
+    int worker_busy = 0;                        // requests taken off the queue but not yet in ready
+    std::condition_variable worker_idle;
+
+    std::unordered_map<uint64_t, drive_playlist_t> playlists;
+    /* bumped by eject(), under request_lock. */
+    std::unordered_map<uint64_t, uint64_t> drive_generation;
+
+    void worker_loop();
+    void queue_request(mount_request_t request);
+    Device_t *storage_device(int slot);
+    media_descriptor *prepare_media(disk_mount_t &disk_mount);
+    int attach_media(disk_mount_t &disk_mount, media_descriptor *media);
+    static void free_media(media_descriptor *media);
+    const char *event_name(const char *filename);
+    void prefetch_next(uint64_t key);
+    void prefetch_arrived(mount_request_t &request);
 
 public:
-    Mounts(cpu_state *cpux) : cpu(cpux) {}
+    Mounts(cpu_state *cpux, SlotManager_t *slotsx) : cpu(cpux), slots(slotsx) {}
+    ~Mounts();
     int mount_media(disk_mount_t disk_mount);
     int unmount_media(disk_mount_t disk_mount);
+
+    /** thread-safe: call from anywhere, e.g. an SDL dialog callback. */
+    void request_mount(disk_mount_t disk_mount);
+    void request_unmount(disk_mount_t disk_mount);
+    /** emulation thread, between CPU bursts: apply whatever the worker has finished. */
+    void process_requests();
+    /** block until the worker has drained the queue, then process_requests(). For headless runs. */
+    void flush_requests();
+
+    /**
+     * Playlists. All of these are emulation-thread calls. swap_next() puts the
+     * next image in the drive (wrapping around); if it was prefetched that
+     * happens right away, otherwise as soon as the worker has it. eject()
+     * empties the drive right away and cancels any mount or swap still on its
+     * way to it - the next swap_next() carries on from where it was.
+     */
+    void set_playlist(uint64_t key, const std::vector<std::string> &images);
+    int swap_next(uint64_t key);
+    void eject(uint64_t key);
+    /** key of the n'th drive that has a playlist, in slot/drive order; 0 if there isn't one. */
+    uint64_t playlist_key(size_t n);
     drive_status_t media_status(uint64_t key);
-    int register_drive(drive_type_t drive_type, uint64_t key);
+    int register_drive(uint64_t key);
     void dump();
+
+    DriveEventQueue *subscribe();
+    void unsubscribe(DriveEventQueue *queue);
+    void publish(uint64_t key, drive_event_type_t type, int32_t value = 0, const char *filename = nullptr);
+    void publish_at(uint64_t key, drive_event_type_t type, uint64_t cycle);
 };
 
 
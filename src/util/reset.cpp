@@ -15,15 +15,25 @@
  *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
+
 #include "gs2.hpp"
 #include "reset.hpp"
 #include "cpu.hpp"
-#include "devices/diskii/diskii.hpp"
-#include "devices/languagecard/languagecard.hpp"
 #include "memory.hpp"
 
-// TODO: implement register_reset_handler so a device can register a reset handler.
-// and when system_reset is called, it will call all the registered reset handlers.
+void register_reset_handler(cpu_state *cpu, reset_handler_t handler) {
+    for (int i = 0; i < cpu->num_reset_handlers; i++) {
+        if (cpu->reset_handlers[i] == handler) {
+            return;
+        }
+    }
+    if (cpu->num_reset_handlers >= MAX_RESET_HANDLERS) {
+        fprintf(stderr, "Too many reset handlers, increase MAX_RESET_HANDLERS\n");
+        return;
+    }
+    cpu->reset_handlers[cpu->num_reset_handlers++] = handler;
+}
 
 void system_reset(cpu_state *cpu, bool cold_start)  {
     // TODO: this should be a callback from the CPU reset handler.
@@ -34,8 +44,9 @@ void system_reset(cpu_state *cpu, bool cold_start)  {
         raw_memory_write(cpu, 0x3f4, 0x00);
     }
 
-    cpu_reset(cpu);
-    diskii_reset(cpu);
-    init_default_memory_map(cpu);
-    reset_languagecard(cpu); // reset language card
+    restore_reset_memory_map(cpu);
+    for (int i = 0; i < cpu->num_reset_handlers; i++) {
+        cpu->reset_handlers[i](cpu);
+    }
+    cpu_reset(cpu); // last, so the vector comes out of the reset memory map
 }
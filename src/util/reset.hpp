@@ -17,4 +17,11 @@
 
 #include "cpu.hpp"
 
+typedef void (*reset_handler_t)(cpu_state *cpu);
+
+/**
+ * A device with state that RESET touches registers a handler from its init.
+ * Registering the same handler again (a second card of the same kind) is a no-op.
+ */
+void register_reset_handler(cpu_state *cpu, reset_handler_t handler);
 void system_reset(cpu_state *cpu, bool cold_start);
@@ -0,0 +1,38 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <time.h>
+
+#include "gs2.hpp"
+#include "cpu.hpp"
+#include "clock.hpp"
+#include "wall_clock.hpp"
+
+bool wall_clock_is_virtual() {
+    return gs2_app_values.clock_epoch != 0;
+}
+
+/* emulated seconds are 1.0205MHz seconds whatever speed we're running at, same as the cycle counter. */
+void wall_clock_now(cpu_state *cpu, struct tm *tm) {
+    if (wall_clock_is_virtual()) {
+        time_t now = (time_t)(gs2_app_values.clock_epoch + cpu->cycles / clock_mode_info[CLOCK_1_024MHZ].hz_rate);
+        gmtime_r(&now, tm);
+    } else {
+        time_t now = time(nullptr);
+        localtime_r(&now, tm);
+    }
+}
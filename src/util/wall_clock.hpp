@@ -0,0 +1,30 @@
+/*
+ *   Copyright (c) 2025 Jawaid Bazyar
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <time.h>
+#include "cpu.hpp"
+
+/**
+ * The date and time the machine's clock cards see. Normally the host's local
+ * time. With -T (gs2_app_values.clock_epoch) it's virtual: the epoch, in UTC,
+ * plus however long the machine has been running by the cycle count. That
+ * doesn't depend on the host at all, so a run can be repeated bit-for-bit.
+ */
+bool wall_clock_is_virtual();
+void wall_clock_now(cpu_state *cpu, struct tm *tm);